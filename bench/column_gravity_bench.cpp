@@ -0,0 +1,98 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "core/cell.hpp"
+#include "core/chunk_updater.hpp"
+#include "simulation/chunk_manager.hpp"
+
+namespace
+{
+    constexpr int c_floor_gap = 4;
+    constexpr int c_pour_steps = 120;
+
+    // the per cell rules only, every fall goes through the move queue
+    class ScalarUpdater : public ChunkUpdater
+    {
+    public:
+        ScalarUpdater(ChunkManager& manager, Chunk* chunk) : ChunkUpdater(manager, chunk) { }
+
+    protected:
+        uint64_t update_row(int /*y*/, uint64_t /*cells*/) override
+        {
+            return 0;
+        }
+    };
+
+    // leaves every cell where it is, settles the rects before the measured step
+    class IdleUpdater : public ChunkWorker
+    {
+    public:
+        IdleUpdater(ChunkManager& manager, Chunk* chunk) : ChunkWorker(manager, chunk) { }
+
+    protected:
+        void update_cell(const Cell& /*cell*/, int /*x*/, int /*y*/) override { }
+    };
+
+    // the top half of the world is sand at rest, a few cells over a stone floor
+    std::unique_ptr<ChunkManager> make_block()
+    {
+        auto manager = std::make_unique<ChunkManager>();
+
+        for (int y = -128; y < 32; y++)
+        {
+            for (int x = -128; x < 192; x++)
+            {
+                manager->set_cell(x, y, Cell::Sand);
+            }
+        }
+
+        for (int x = -128; x < 192; x++)
+        {
+            manager->set_cell(x, 32 + c_floor_gap, Cell::Stone);
+        }
+
+        manager->update<IdleUpdater>(1.0f / 59.0f);
+
+        return manager;
+    }
+
+    // the block pours onto the floor from the bottom up, the rows above are still at rest while the lower ones
+    // speed up and land, too close to the floor to be launched
+    template<typename Updater>
+    void measure_pour(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<std::unique_ptr<ChunkManager>> managers;
+
+        for (int i = 0; i < meter.runs(); i++)
+        {
+            managers.push_back(make_block());
+        }
+
+        meter.measure([&](int i)
+        {
+            for (int step = 0; step < c_pour_steps; step++)
+            {
+                managers[i]->update<Updater>(1.0f / 59.0f);
+            }
+
+            return managers[i]->get_step();
+        });
+    }
+}
+
+TEST_CASE("Column gravity against per cell falls", "[!benchmark][ColumnGravity]")
+{
+    BENCHMARK_ADVANCED("per cell pour of a block")(Catch::Benchmark::Chronometer meter)
+    {
+        measure_pour<ScalarUpdater>(meter);
+    };
+
+    BENCHMARK_ADVANCED("bulk pour of a block")(Catch::Benchmark::Chronometer meter)
+    {
+        measure_pour<ChunkUpdater>(meter);
+    };
+}
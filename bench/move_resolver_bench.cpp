@@ -0,0 +1,116 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <algorithm>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "core/chunk_context.hpp"
+#include "simulation/move_resolver.hpp"
+
+namespace
+{
+    constexpr int c_width = ChunkContext::width;
+    constexpr int c_height = ChunkContext::height;
+
+    struct BenchChange
+    {
+        int src_index = 0;
+        int dst_index = 0;
+    };
+
+    // cells move to one of their 8 neighbours, the same way the updater rules do
+    std::vector<BenchChange> make_changes(float density, std::mt19937& random)
+    {
+        std::vector<BenchChange> changes;
+        std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+        std::uniform_int_distribution<int> offset(-1, 1);
+
+        for (int y = 1; y < c_height - 1; y++)
+        {
+            for (int x = 1; x < c_width - 1; x++)
+            {
+                if (chance(random) >= density) continue;
+
+                const int dst_x = x + offset(random);
+                const int dst_y = y + offset(random);
+
+                changes.push_back({ x + y * c_width, dst_x + dst_y * c_width });
+            }
+        }
+
+        std::shuffle(changes.begin(), changes.end(), random);
+
+        return changes;
+    }
+
+    // the old Chunk::apply_moved_cells path, sort by destination then pick one of each group
+    template<typename Apply>
+    void resolve_sorted(std::vector<BenchChange>& changes, std::mt19937& random, Apply&& apply)
+    {
+        std::sort(changes.begin(), changes.end(), [](const auto& a, const auto& b) 
+        {
+            return a.dst_index < b.dst_index;
+        });
+
+        size_t prev_iter = 0;
+        changes.push_back({ -1, -1 });
+
+        for (size_t i = 0; i + 1 < changes.size(); i++)
+        {
+            if (changes[i].dst_index != changes[i + 1].dst_index)
+            {
+                const size_t chosen = std::uniform_int_distribution<size_t>(prev_iter, i)(random);
+                apply(changes[chosen]);
+
+                prev_iter = i + 1;
+            }
+        }
+
+        changes.pop_back();
+    }
+}
+
+TEST_CASE("Move resolver against sorting", "[!benchmark][MoveResolver]")
+{
+    std::mt19937 random(42);
+    MoveResolver<c_width * c_height> resolver;
+
+    const auto priority = [&](const BenchChange& change)
+    {
+        return static_cast<uint64_t>(random()) << 32 | static_cast<uint64_t>(change.src_index);
+    };
+
+    for (const float density : { 0.01f, 0.1f, 0.5f, 1.0f })
+    {
+        const std::vector<BenchChange> changes = make_changes(density, random);
+        const std::string label = std::to_string(static_cast<int>(density * 100)) + "% (" + std::to_string(changes.size()) + " changes)";
+
+        BENCHMARK_ADVANCED("sort " + label)(Catch::Benchmark::Chronometer meter)
+        {
+            std::vector<std::vector<BenchChange>> runs(meter.runs(), changes);
+
+            meter.measure([&](int i)
+            {
+                int applied = 0;
+                resolve_sorted(runs[i], random, [&](const BenchChange&) { applied++; });
+
+                return applied;
+            });
+        };
+
+        BENCHMARK_ADVANCED("claim " + label)(Catch::Benchmark::Chronometer meter)
+        {
+            std::vector<std::vector<BenchChange>> runs(meter.runs(), changes);
+
+            meter.measure([&](int i)
+            {
+                int applied = 0;
+                resolver.resolve(std::span<const BenchChange>(runs[i]), priority, [&](const BenchChange&) { applied++; });
+
+                return applied;
+            });
+        };
+    }
+}
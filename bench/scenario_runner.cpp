@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scenarios.hpp"
+#include "core/chunk_updater.hpp"
+#include "simulation/chunk_manager.hpp"
+
+namespace
+{
+    std::atomic<size_t> s_allocations = 0;
+    std::atomic<size_t> s_cell_updates = 0;
+
+    // chunk sizes --chunk-size all runs, a row of a chunk has to fit into a 64 bit mask
+    constexpr std::array<int, 3> c_chunk_sizes = { 16, 32, 64 };
+
+    // counts the cells it updates, added up once per chunk to keep threads off the counter
+    template<typename Context>
+    class CountingUpdater : public BasicChunkUpdater<Context>
+    {
+    public:
+        CountingUpdater(BasicChunkManager<Context>& manager, BasicChunk<Context>* chunk) : BasicChunkUpdater<Context>(manager, chunk) { }
+
+        ~CountingUpdater()
+        {
+            s_cell_updates.fetch_add(m_cell_updates, std::memory_order_relaxed);
+        }
+
+    protected:
+        void update_cell(const Cell& cell, int x, int y) override
+        {
+            BasicChunkUpdater<Context>::update_cell(cell, x, y);
+            m_cell_updates++;
+        }
+
+        // cells the row kernels took care of count as well
+        uint64_t update_row(int y, uint64_t cells) override
+        {
+            const uint64_t updated = BasicChunkUpdater<Context>::update_row(y, cells);
+            m_cell_updates += std::popcount(updated);
+
+            return updated;
+        }
+
+    private:
+        size_t m_cell_updates = 0;
+    };
+
+    struct Options
+    {
+        int threads = static_cast<int>(std::thread::hardware_concurrency());
+        int steps = 0; // 0 keeps each scenarios own count
+        std::string filter;
+        std::vector<int> chunk_sizes = { 64 };
+        std::string output = "benchmark_results.json";
+        std::string baseline;
+        double tolerance = 0.10;
+    };
+
+    struct Result
+    {
+        std::string name;
+        int steps = 0;
+        int threads = 0;
+        int chunk_size = 64;
+        double seconds = 0;
+        double steps_per_second = 0;
+        double cell_updates_per_second = 0;
+        size_t allocations = 0;
+    };
+
+    std::optional<Options> parse_options(int argc, char** argv)
+    {
+        Options options;
+
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+            if (value == nullptr) return std::nullopt;
+
+            if (arg == "--threads")        options.threads = std::atoi(value);
+            else if (arg == "--steps")     options.steps = std::atoi(value);
+            else if (arg == "--filter")    options.filter = value;
+            else if (arg == "--chunk-size")
+            {
+                const int size = std::atoi(value);
+
+                if (std::string(value) == "all") options.chunk_sizes.assign(c_chunk_sizes.begin(), c_chunk_sizes.end());
+                else if (std::find(c_chunk_sizes.begin(), c_chunk_sizes.end(), size) != c_chunk_sizes.end()) options.chunk_sizes = { size };
+                else return std::nullopt;
+            }
+            else if (arg == "--output")    options.output = value;
+            else if (arg == "--baseline")  options.baseline = value;
+            else if (arg == "--tolerance") options.tolerance = std::atof(value);
+            else return std::nullopt;
+
+            i++;
+        }
+
+        return options;
+    }
+
+    template<int Size>
+    Result run_scenario(const Scenario& scenario, const Options& options)
+    {
+        using Context = BenchContext<Size>;
+
+        BasicChunkManager<Context> manager(options.threads);
+        const CellSetter set_cell = [&](int x, int y, const Cell& cell) { manager.set_cell(x, y, cell); };
+
+        scenario.setup(set_cell);
+
+        const int steps = options.steps > 0 ? options.steps : scenario.steps;
+        const float time_step = manager.get_time_step();
+
+        // an update never runs more than the one step it was fed, so every step gets its tick
+        manager.set_catch_up_limits(1, 0);
+
+        s_cell_updates = 0;
+        s_allocations = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        // feed a little over a step each update, the step runs once the accumulator is past it
+        // and the rounding left over is far less than a step, so it is never dropped
+        while (manager.get_step() < static_cast<uint64_t>(steps))
+        {
+            if (scenario.tick) scenario.tick(set_cell, static_cast<int>(manager.get_step()));
+
+            manager.template update<CountingUpdater<Context>>(time_step * 1.001f);
+        }
+
+        // what actually ran, not what was asked for
+        const uint64_t steps_run = manager.get_step();
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        Result result;
+        result.name = scenario.name;
+        result.steps = static_cast<int>(steps_run);
+        result.threads = static_cast<int>(manager.get_thread_count());
+        result.chunk_size = Size;
+        result.seconds = seconds;
+        result.steps_per_second = steps_run / seconds;
+        result.cell_updates_per_second = s_cell_updates / seconds;
+        result.allocations = s_allocations;
+
+        return result;
+    }
+
+    Result run_scenario(const Scenario& scenario, int chunk_size, const Options& options)
+    {
+        switch (chunk_size)
+        {
+            case 16: return run_scenario<16>(scenario, options);
+            case 32: return run_scenario<32>(scenario, options);
+            default: return run_scenario<64>(scenario, options);
+        }
+    }
+
+    // one scenario per line, read_baseline relies on that
+    bool write_results(const std::string& path, const std::vector<Result>& results)
+    {
+        std::ofstream file(path);
+
+        file << "{\n  \"scenarios\": [\n";
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result& result = results[i];
+
+            file 
+                << "    { \"name\": \"" << result.name << "\""
+                << ", \"steps\": " << result.steps
+                << ", \"threads\": " << result.threads
+                << ", \"chunk_size\": " << result.chunk_size
+                << ", \"seconds\": " << result.seconds
+                << ", \"steps_per_second\": " << result.steps_per_second
+                << ", \"cell_updates_per_second\": " << result.cell_updates_per_second
+                << ", \"allocations\": " << result.allocations
+                << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+
+        file << "  ]\n}\n";
+
+        return file.good();
+    }
+
+    std::optional<double> find_number(const std::string& line, const std::string& key)
+    {
+        const size_t at = line.find("\"" + key + "\":");
+
+        if (at == std::string::npos) return std::nullopt;
+
+        return std::atof(line.c_str() + at + key.size() + 3);
+    }
+
+    std::optional<std::string> find_string(const std::string& line, const std::string& key)
+    {
+        const size_t at = line.find("\"" + key + "\": \"");
+
+        if (at == std::string::npos) return std::nullopt;
+
+        const size_t start = at + key.size() + 5;
+        const size_t end = line.find('"', start);
+
+        if (end == std::string::npos) return std::nullopt;
+
+        return line.substr(start, end - start);
+    }
+
+    std::vector<Result> read_baseline(const std::string& path)
+    {
+        std::vector<Result> results;
+        std::ifstream file(path);
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            const std::optional<std::string> name = find_string(line, "name");
+            const std::optional<double> steps_per_second = find_number(line, "steps_per_second");
+
+            if (!name || !steps_per_second) continue;
+
+            Result result;
+            result.name = *name;
+            result.steps_per_second = *steps_per_second;
+            // results from before the sweep were all 64
+            result.chunk_size = static_cast<int>(find_number(line, "chunk_size").value_or(64));
+            results.push_back(result);
+        }
+
+        return results;
+    }
+
+    // true when no scenario got slower than the baseline by more than the tolerance
+    bool compare_to_baseline(const std::vector<Result>& results, const std::vector<Result>& baseline, double tolerance)
+    {
+        bool passed = true;
+
+        for (const Result& result : results)
+        {
+            for (const Result& base : baseline)
+            {
+                if (base.name != result.name || base.chunk_size != result.chunk_size) continue;
+
+                const double change = result.steps_per_second / base.steps_per_second - 1.0;
+                const bool regressed = change < -tolerance;
+
+                std::printf("%-16s %3d %+7.1f%% vs baseline%s\n", result.name.c_str(), result.chunk_size, change * 100.0, regressed ? "  REGRESSION" : "");
+
+                passed = passed && !regressed;
+            }
+        }
+
+        return passed;
+    }
+}
+
+// count every allocation made while the scenarios run
+void* operator new(size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+int main(int argc, char** argv)
+{
+    const std::optional<Options> options = parse_options(argc, argv);
+
+    if (!options)
+    {
+        std::printf("usage: SandSimulatorBenchmarks [--threads n] [--steps n] [--filter name] [--chunk-size 16|32|64|all] [--output file] [--baseline file] [--tolerance 0.1]\n");
+        return 2;
+    }
+
+    std::vector<Result> results;
+
+    for (const Scenario& scenario : make_scenarios())
+    {
+        if (!options->filter.empty() && scenario.name.find(options->filter) == std::string::npos) continue;
+
+        for (const int chunk_size : options->chunk_sizes)
+        {
+            const Result& result = results.emplace_back(run_scenario(scenario, chunk_size, *options));
+
+            std::printf("%-16s %3d %6d steps %8.1f steps/s %12.0f cells/s %8zu allocations\n", 
+                result.name.c_str(), result.chunk_size, result.steps, result.steps_per_second, result.cell_updates_per_second, result.allocations);
+        }
+    }
+
+    if (!write_results(options->output, results))
+    {
+        std::printf("couldnt write %s\n", options->output.c_str());
+        return 1;
+    }
+
+    if (!options->baseline.empty())
+    {
+        const std::vector<Result> baseline = read_baseline(options->baseline);
+
+        if (baseline.empty())
+        {
+            std::printf("couldnt read baseline %s\n", options->baseline.c_str());
+            return 1;
+        }
+
+        if (!compare_to_baseline(results, baseline, options->tolerance)) return 1;
+    }
+
+    return 0;
+}
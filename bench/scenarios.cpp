@@ -0,0 +1,107 @@
+#include "scenarios.hpp"
+
+namespace
+{
+    // the whole world in cells, the same for every chunk size
+    constexpr int c_min_x = -128;
+    constexpr int c_min_y = -128;
+    constexpr int c_max_x = 191;
+    constexpr int c_max_y = 191;
+
+    static_assert(BenchContext<64>::min_chunk_pos.x * 64 == c_min_x && (BenchContext<64>::max_chunk_pos.x + 1) * 64 - 1 == c_max_x);
+    static_assert(BenchContext<16>::min_chunk_pos.y * 16 == c_min_y && (BenchContext<16>::max_chunk_pos.y + 1) * 16 - 1 == c_max_y);
+
+    void fill_rect(const CellSetter& set_cell, int min_x, int min_y, int max_x, int max_y, const Cell& cell)
+    {
+        for (int y = min_y; y <= max_y; y++)
+        {
+            for (int x = min_x; x <= max_x; x++)
+            {
+                set_cell(x, y, cell);
+            }
+        }
+    }
+
+    void add_floor(const CellSetter& set_cell)
+    {
+        fill_rect(set_cell, c_min_x, c_max_y - 3, c_max_x, c_max_y, Cell::Stone);
+    }
+}
+
+std::vector<Scenario> make_scenarios()
+{
+    std::vector<Scenario> scenarios;
+
+    // a tall block of sand falling apart onto the floor
+    scenarios.push_back({ .name = "sand_pile", .steps = 600, .setup = [](const CellSetter& set_cell)
+    {
+        add_floor(set_cell);
+        fill_rect(set_cell, c_min_x + 60, c_min_y + 20, c_max_x - 60, c_max_y - 60, Cell::Sand);
+    }, .tick = {} });
+
+    // water released from one side over a bumpy stone floor
+    scenarios.push_back({ .name = "water_flood", .steps = 600, .setup = [](const CellSetter& set_cell)
+    {
+        add_floor(set_cell);
+
+        for (int x = c_min_x; x <= c_max_x; x += 24)
+        {
+            fill_rect(set_cell, x, c_max_y - 10, x + 6, c_max_y - 4, Cell::Stone);
+        }
+
+        fill_rect(set_cell, c_min_x, c_min_y + 100, c_min_x + 100, c_max_y - 4, Cell::Water);
+    }, .tick = {} });
+
+    // smoke rising from the floor and spreading under a ceiling
+    scenarios.push_back({ .name = "smoke_column", .steps = 600, .setup = [](const CellSetter& set_cell)
+    {
+        fill_rect(set_cell, c_min_x, c_min_y, c_max_x, c_min_y + 3, Cell::Stone);
+    }, .tick = [](const CellSetter& set_cell, int /*step*/)
+    {
+        fill_rect(set_cell, -8, c_max_y - 20, 8, c_max_y - 4, Cell::Smoke);
+    } });
+
+    // a settled world with a few taps dripping into it, most chunks stay asleep
+    scenarios.push_back({ .name = "mostly_asleep", .steps = 1200, .setup = [](const CellSetter& set_cell)
+    {
+        add_floor(set_cell);
+        fill_rect(set_cell, c_min_x, c_min_y + 160, c_max_x, c_max_y - 4, Cell::Stone);
+    }, .tick = [](const CellSetter& set_cell, int step)
+    {
+        if (step % 4 != 0) return;
+
+        for (int x = c_min_x + 40; x <= c_max_x; x += 120)
+        {
+            set_cell(x, c_min_y + 2, Cell::Water);
+        }
+    } });
+
+    // smoke puffing in opposite corners of every 64 cell block of settled stone
+    scenarios.push_back({ .name = "corner_spots", .steps = 1200, .setup = [](const CellSetter& set_cell)
+    {
+        fill_rect(set_cell, c_min_x, c_min_y, c_max_x, c_max_y, Cell::Stone);
+
+        for (int y = c_min_y; y <= c_max_y; y += 64)
+        {
+            for (int x = c_min_x; x <= c_max_x; x += 64)
+            {
+                fill_rect(set_cell, x + 2, y + 2, x + 9, y + 9, Cell());
+                fill_rect(set_cell, x + 54, y + 54, x + 61, y + 61, Cell());
+            }
+        }
+    }, .tick = [](const CellSetter& set_cell, int step)
+    {
+        if (step % 4 != 0) return;
+
+        for (int y = c_min_y; y <= c_max_y; y += 64)
+        {
+            for (int x = c_min_x; x <= c_max_x; x += 64)
+            {
+                set_cell(x + 5, y + 9, Cell::Smoke);
+                set_cell(x + 58, y + 61, Cell::Smoke);
+            }
+        }
+    } });
+
+    return scenarios;
+}
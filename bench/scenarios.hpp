@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "core/cell.hpp"
+#include "core/chunk_context.hpp"
+
+// every benchmarked chunk size covers the same 320 x 320 cells, so scenarios dont depend on it
+template<int Size>
+using BenchContext = BasicChunkContext<Size, Size, 4, Point{ -128 / Size, -128 / Size }, Point{ 192 / Size - 1, 192 / Size - 1 }>;
+
+// scenarios only place cells, which works the same for any chunk size
+using CellSetter = std::function<void(int x, int y, const Cell& cell)>;
+
+// a world built in code and how long to run it for
+struct Scenario
+{
+    std::string name;
+    int steps = 0;
+
+    std::function<void(const CellSetter&)> setup;
+    // called before every step, can be empty
+    std::function<void(const CellSetter&, int)> tick;
+};
+
+std::vector<Scenario> make_scenarios();
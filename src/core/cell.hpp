@@ -1,9 +1,11 @@
 #pragma once
 
+#include <cstdint>
+
 #include "utils/colour.hpp"
 #include "utils/point.hpp"
 
-enum class CellType
+enum class CellType : uint8_t
 {
     Empty = 0,
     Sand,
@@ -31,6 +33,9 @@ struct Cell
     const static Cell Water;
     const static Cell Fire;
     const static Cell Smoke;
+
+    // the values a cell of this type starts with, looked up in the material registry
+    static const Cell& get_default(CellType type);
 };
 
 constexpr Cell Cell::Empty  = Cell(CellType::Empty, Colour::Blank);
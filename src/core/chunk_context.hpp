@@ -1,15 +1,62 @@
 #pragma once
 
+#include <bit>
+#include <cstdint>
+
 #include "utils/point.hpp"
 
-struct ChunkContext
+// sizes of a chunk and the world, chunks and managers are built for one context at compile time
+// so differently sized worlds can live side by side
+template<int Width, int Height, int CellSize, Point MinChunkPos, Point MaxChunkPos>
+struct BasicChunkContext
 {
-    static constexpr int width = 64;
-    static constexpr int height = 64;
-    static constexpr int cell_size = 4;
+    static constexpr int width = Width;
+    static constexpr int height = Height;
+    static constexpr int cell_size = CellSize;
+    static constexpr int halo = 2; // cells copied in from the neighbours each step
+    static constexpr int tile_size = 16; // chunks track what is awake per tile of this many cells a side
+
+    // the world edge, managers allocate chunk slots a page at a time so a wide world only pays for the chunks in it
+    static constexpr Point min_chunk_pos = MinChunkPos;
+    static constexpr Point max_chunk_pos = MaxChunkPos;
+
+    static constexpr int64_t max_chunks =
+        (static_cast<int64_t>(max_chunk_pos.x) - min_chunk_pos.x + 1) * (static_cast<int64_t>(max_chunk_pos.y) - min_chunk_pos.y + 1);
+
+    // power of two sides turn the conversions below into shifts and masks
+    static constexpr bool pow2_width = std::has_single_bit(static_cast<unsigned>(width));
+    static constexpr bool pow2_height = std::has_single_bit(static_cast<unsigned>(height));
+
+    static_assert(width > 0 && height > 0 && cell_size > 0, "chunks need a size");
+    static_assert(min_chunk_pos.x <= max_chunk_pos.x && min_chunk_pos.y <= max_chunk_pos.y, "the world needs at least one chunk");
+
+    // chunk a cell is in, rounds towards negative infinity
+    static constexpr Point cell_to_chunk(int x, int y)
+    {
+        return { floor_div<width, pow2_width>(x), floor_div<height, pow2_height>(y) };
+    }
+
+    // position of a cell inside its chunk, always positive
+    static constexpr Point cell_to_local(int x, int y)
+    {
+        return { floor_mod<width, pow2_width>(x), floor_mod<height, pow2_height>(y) };
+    }
+
+private:
+    template<int Size, bool Pow2>
+    static constexpr int floor_div(int value)
+    {
+        // right shifts of negative numbers are arithmetic since c++20
+        if constexpr (Pow2) return value >> std::countr_zero(static_cast<unsigned>(Size));
+        else                return value >= 0 ? value / Size : (value - Size + 1) / Size;
+    }
 
-    static constexpr Point min_chunk_pos = { -2, -2 };
-    static constexpr Point max_chunk_pos = { +2, +2 };
+    template<int Size, bool Pow2>
+    static constexpr int floor_mod(int value)
+    {
+        if constexpr (Pow2) return value & (Size - 1);
+        else                return (value % Size + Size) % Size;
+    }
+};
 
-    static constexpr int max_chunks = (max_chunk_pos.x - min_chunk_pos.x + 1) * (max_chunk_pos.y - min_chunk_pos.y + 1);
-};
\ No newline at end of file
+using ChunkContext = BasicChunkContext<64, 64, 4, Point{ -2, -2 }, Point{ +2, +2 }>;
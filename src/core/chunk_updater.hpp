@@ -1,175 +1,281 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
 #include "core/cell.hpp"
+#include "core/material_registry.hpp"
+#include "utils/byte_classifier.hpp"
 #include "simulation/chunk.hpp"
 #include "simulation/chunk_worker.hpp"
 #include "simulation/chunk_manager.hpp"
 
-class ChunkUpdater : public ChunkWorker
+template<typename Context>
+class BasicChunkUpdater : public BasicChunkWorker<Context>
 {
+    using Worker = BasicChunkWorker<Context>;
+
 public:
-    ChunkUpdater(ChunkManager& manager, Chunk* chunk) : ChunkWorker(manager, chunk) { }
+    BasicChunkUpdater(typename Worker::ManagerType& manager, typename Worker::ChunkType* chunk) : Worker(manager, chunk), m_materials(MaterialRegistry::get()) { }
 
 protected:
-    void update_cell(const Cell& cell, int x, int y)
+    using Worker::move_cell;
+    using Worker::swap_cells;
+    using Worker::is_empty;
+    using Worker::get_type;
+    using Worker::get_random;
+    using Worker::set_velocity;
+    using Worker::trace_path;
+    using Worker::launch_cell;
+    using Worker::drop_cells;
+    using Worker::get_chunk;
+    using Worker::get_grid_position;
+
+    void update_cell(const Cell& cell, int x, int y) override
     {
-        int dest_x = 0;
-        int dest_y = 0;
+        const Material& material = m_materials.get_material(cell.type);
 
-        if (cell.type == CellType::Sand)
+        // one branch on the movement class, materials only differ by their registry values
+        switch (material.movement)
         {
-            bool can_down = is_empty(x, y + 1);
-            bool has_type_down = has_types_at<2>(x, y + 1, {
-                CellType::Water,
-                CellType::Smoke
-            });
-            bool can_hor = try_random_dver(x, y, dest_x, dest_y);
-
-            // if (can_down)
-            // {
-            //     move_cell(x, y, x, y + 1);
-            // }
-            // else
-            {
-                push_cell(x, y, 5, -5);
-            }
-            // else if (has_type_down)
-            // {
-            //     swap_cells(x, y, x, y + 1);
-            // }
-            // else if (can_hor) 
-            // {
-            //     move_cell(x, y, dest_x, dest_y);
-            // }
+            case MovementClass::Powder: update_powder(cell, material, x, y); break;
+            case MovementClass::Liquid: update_fluid(cell, material, x, y, +1); break;
+            case MovementClass::Gas:    update_fluid(cell, material, x, y, -1); break;
+            default: break;
         }
+    }
+
+    // column gravity for a whole row, cells falling straight down that stay in the grid are queued as a mask per row,
+    // and powder with nothing it could move into below it is left alone, the rest goes through update_cell
+    // both read the grid from before the step, so they move every cell the same
+    uint64_t update_row(int y, uint64_t cells) override
+    {
+        constexpr int width = Context::width;
+        constexpr int height = Context::height;
+
+        // the last row falls into the next chunk
+        if (y + 1 >= height) return 0;
+
+        const auto& chunk = get_chunk();
+        const ByteClassifier& table = m_materials.get_fall_table();
+        const uint8_t* row = reinterpret_cast<const uint8_t*>(chunk.get_row_types(y));
+
+        const uint64_t falling = cells & table.match(row, width, MaterialRegistry::c_falls_as_powder | MaterialRegistry::c_falls_as_liquid);
 
-        if (cell.type == CellType::Water)
+        if (falling == 0) return 0;
+
+        const uint8_t* below = reinterpret_cast<const uint8_t*>(chunk.get_row_types(y + 1));
+        const uint64_t powder = falling & table.match(row, width, MaterialRegistry::c_falls_as_powder);
+        const uint64_t blocked = table.match(below, width, MaterialRegistry::c_blocks_falling);
+
+        // the halo has the columns of the chunks next to this one
+        const uint64_t blocked_left = (blocked << 1) | uint64_t((table.get_flags(below[-1]) & MaterialRegistry::c_blocks_falling) != 0);
+        const uint64_t blocked_right = (blocked >> 1) | (uint64_t((table.get_flags(below[width]) & MaterialRegistry::c_blocks_falling) != 0) << (width - 1));
+
+        // a moving cell goes further than one cell, or has to stop first
+        const uint64_t moving = falling & chunk.get_moving_mask(y);
+
+        // a move from the chunks edge wakes the neighbours, and an expiring life time changes the grid during the step
+        const bool can_drop = y > 0 && !chunk.has_life_times();
+
+        const uint64_t settled = powder & blocked & blocked_left & blocked_right;
+        const uint64_t resting = settled & ~moving;
+        const uint64_t drops = can_drop ? falling & ~moving & ~chunk.get_row_mask(y + 1) & c_inner_columns : 0;
+        ColumnDrops moving_drops;
+
+        // at rest a cell speeds up to one cell a step, the first step of its fall
+        drop_cells(y, drops, 1, { 0, 1 });
+
+        for (uint64_t moved = can_drop ? moving & c_inner_columns : 0; moved != 0; moved &= moved - 1)
         {
-            if (is_empty(x, y + 1))
-            {
-                move_cell(x, y, x, y + 1);
-            }
-            else if (try_random_dver(x, y, dest_x, dest_y))
-            {
-                move_cell(x, y, dest_x, dest_y);
-            }
-            else if (try_random_dhor(x, y, dest_x, dest_y)) 
-            { 
-                move_cell(x, y, dest_x, dest_y);
-            }
+            const int x = std::countr_zero(moved);
+
+            add_moving_drop(moving_drops, x, y, static_cast<CellType>(row[x]), settled & (uint64_t(1) << x));
         }
 
-        if (cell.type == CellType::Smoke)
+        // one queued mask per distance, and how fast the cells still go after it
+        for (int distance = 1; distance <= Worker::c_max_speed; distance++)
         {
-            if (is_empty(x, y - 1))
-            {
-                move_cell(x, y, x, y - 1);
-            }
-            else if (try_random_uver(x, y, dest_x, dest_y))
-            {
-                move_cell(x, y, dest_x, dest_y);
-            }
-            else if (try_random_uhor(x, y, dest_x, dest_y)) 
-            { 
-                move_cell(x, y, dest_x, dest_y);
-            }
+            drop_cells(y, moving_drops.reached[distance - 1], distance, { 0, distance });
+            drop_cells(y, moving_drops.stopped[distance - 1], distance, Point::zero());
         }
-    }
 
-private:
-    template<int N>
-    bool has_types_at(int x, int y, std::array<CellType, N>&& type)
-    {
-        for (int i = 0; i < N; i++)
+        for (uint64_t landed = moving_drops.landed; landed != 0; landed &= landed - 1)
         {
-            const Cell* cell = get_cell(x, y);
-            
-            if (cell != nullptr && cell->type == type[i])
-            {
-                return true;
-            }
+            set_velocity(get_grid_position().x + std::countr_zero(landed), get_grid_position().y + y, Point::zero());
         }
 
-        return false;
+        return drops | moving_drops.handled | resting;
     }
 
-    bool try_random_dver(int x, int y, int& dest_x, int& dest_y)
+private:
+    // cells of a row moving straight down, by how far they go
+    struct ColumnDrops
     {
-        Point dest = random_direction_movement({ x, y }, { x - 1, y + 1 }, { x + 1, y + 1 });
+        std::array<uint64_t, Worker::c_max_speed> reached{}; // keep their speed
+        std::array<uint64_t, Worker::c_max_speed> stopped{}; // hit something on the way
+        uint64_t landed = 0; // stay where they are and lose their speed
+        uint64_t handled = 0;
+    };
 
-        if (dest != Point::zero())
-        {
-            dest_x = dest.x;
-            dest_y = dest.y;
+    // falls straight down or slides down a slope
+    void update_powder(const Cell& cell, const Material& material, int x, int y)
+    {
+        if (fall(cell, material, x, y, 1)) return;
+        if (try_move(cell.type, x, y, x, y + 1)) return;
 
-            return true;
-        }
+        try_random_side(cell.type, x, y, 1);
+    }
 
-        return false;
+    // liquids fall and gases rise, both spread sideways when they cant
+    void update_fluid(const Cell& cell, const Material& material, int x, int y, int direction)
+    {
+        if (fall(cell, material, x, y, direction)) return;
+        if (try_move(cell.type, x, y, x, y + direction)) return;
+        if (try_random_side(cell.type, x, y, direction)) return;
+
+        spread(material.dispersion, x, y);
     }
 
-    bool try_random_uver(int x, int y, int& dest_x, int& dest_y)
+    // speeds up by a cell per step and moves along its velocity through empty cells
+    // anything in the way stops it, false if it couldnt move at all
+    bool fall(const Cell& cell, const Material& material, int x, int y, int direction)
     {
-        Point dest = random_direction_movement({ x, y }, { x - 1, y - 1 }, { x + 1, y - 1 });
+        const int max_speed = std::min(material.max_speed, Worker::c_max_speed);
+
+        const Point velocity = {
+            std::clamp(cell.velocity.x, -max_speed, max_speed),
+            std::clamp(cell.velocity.y + direction, -max_speed, max_speed),
+        };
+
+        const Point target = { x + velocity.x, y + velocity.y };
+        const Point reached = trace_path(x, y, target.x, target.y);
 
-        if (dest != Point::zero())
+        if (reached == Point(x, y))
         {
-            dest_x = dest.x;
-            dest_y = dest.y;
+            // landed, setting a zero velocity is free for chunks that never had one
+            if (cell.velocity != Point::zero()) set_velocity(x, y, Point::zero());
 
+            return false;
+        }
+
+        // falling freely and fast, the particles take it from here
+        if (reached == target && direction > 0 && velocity.y >= c_launch_speed)
+        {
+            launch_cell(x, y, velocity);
             return true;
         }
 
-        return false;
+        // the velocity moves with the cell
+        set_velocity(x, y, reached == target ? velocity : Point::zero());
+        move_cell(x, y, reached.x, reached.y);
+
+        return true;
     }
 
-    bool try_random_dhor(int x, int y, int& dest_x, int& dest_y)
+    // fall() for a cell moving straight down through its own chunk, and a powder cell landing where it cant slide
+    // left out if it lands anywhere else, launches or leaves the chunk
+    void add_moving_drop(ColumnDrops& drops, int x, int y, CellType type, bool settled) const
     {
-        Point dest = random_direction_movement({ x, y }, { x - 1, y }, { x + 1, y });
+        const auto& chunk = get_chunk();
+        const Point velocity = chunk.get_velocity(x + y * Context::width);
 
-        if (dest != Point::zero())
+        if (velocity.x != 0) return;
+
+        const int max_speed = std::min(m_materials.get_material(type).max_speed, Worker::c_max_speed);
+        const int speed = std::clamp(velocity.y + 1, -max_speed, max_speed);
+        const uint64_t column = uint64_t(1) << x;
+
+        // as far as the column is empty, like trace_path
+        int distance = 0;
+
+        while (distance < speed && y + distance + 1 < Context::height && !(chunk.get_row_mask(y + distance + 1) & column))
         {
-            dest_x = dest.x;
-            dest_y = dest.y;
+            distance++;
+        }
 
-            return true;
+        // landed, nothing below it moves out of the way
+        if (distance == 0 && speed >= 1 && settled)
+        {
+            drops.landed |= column;
+            drops.handled |= column;
+            return;
         }
 
-        return false;
+        if (distance == 0) return;
+
+        const bool reached = distance == speed;
+
+        // the path goes on into the chunk below, or the cell is fast enough to be launched
+        if (!reached && y + distance + 1 >= Context::height) return;
+        if (reached && speed >= c_launch_speed) return;
+
+        (reached ? drops.reached : drops.stopped)[distance - 1] |= column;
+        drops.handled |= column;
     }
 
-    bool try_random_uhor(int x, int y, int& dest_x, int& dest_y)
+    // moves into empty space or swaps with a cell the material can displace
+    bool try_move(CellType type, int x, int y, int to_x, int to_y)
     {
-        Point dest = random_direction_movement({ x, y }, { x - 1, y }, { x + 1, y });
+        const CellType target = get_type(to_x, to_y);
 
-        if (dest != Point::zero())
+        if (target == CellType::Empty)
         {
-            dest_x = dest.x;
-            dest_y = dest.y;
+            move_cell(x, y, to_x, to_y);
+            return true;
+        }
 
+        if (m_materials.can_displace(type, target))
+        {
+            swap_cells(x, y, to_x, to_y);
             return true;
         }
 
         return false;
     }
 
-    Point random_direction_movement(Point from, Point to_a, Point to_b)
+    // tries a random side first, then the other one
+    bool try_random_side(CellType type, int x, int y, int offset_y)
     {
-        bool options[2] = { 
-            is_empty(to_a.x, to_a.y), 
-            is_empty(to_b.x, to_b.y) 
-        };
+        const int side = (get_random(x, y) & 1) ? 1 : -1;
+
+        return try_move(type, x, y, x + side, y + offset_y) || try_move(type, x, y, x - side, y + offset_y);
+    }
+
+    // slides as far as dispersion allows through empty cells
+    void spread(int dispersion, int x, int y)
+    {
+        const int first_side = (get_random(x, y, 1) & 1) ? 1 : -1;
 
-        if (options[0] && options[1])
+        for (const int side : { first_side, -first_side })
         {
-            int r = rand() % 2;
+            int reach = 0;
 
-            if (r == 0) return to_a;
-            if (r == 1) return to_b;
-        }
-        else if (options[0]) return to_a;
-        else if (options[1]) return to_b;
+            while (reach < dispersion && is_empty(x + side * (reach + 1), y))
+            {
+                reach++;
+            }
 
-        return {};
+            if (reach > 0)
+            {
+                move_cell(x, y, x + side * reach, y);
+                return;
+            }
+        }
     }
-};
\ No newline at end of file
+
+private:
+    // slower cells stay in the grid where they can still slide and swap
+    static constexpr int c_launch_speed = 3;
+
+    // columns a move can start from without waking the chunks to the sides
+    static constexpr uint64_t c_inner_columns = 
+        (~uint64_t(0) >> (64 - Context::width + 1)) & (~uint64_t(0) << 1);
+
+private:
+    const MaterialRegistry& m_materials;
+};
+
+using ChunkUpdater = BasicChunkUpdater<ChunkContext>;
@@ -0,0 +1,335 @@
+#include "core/material_registry.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    struct BuiltinMaterial
+    {
+        const Cell& cell;
+        const char* name;
+        MovementClass movement;
+        float density;
+    };
+
+    // the materials the code knows about, colours and lifetimes come from the Cell constants
+    const BuiltinMaterial c_builtin_materials[] = {
+        { Cell::Empty, "empty", MovementClass::None,   0.0f },
+        { Cell::Sand,  "sand",  MovementClass::Powder, 1.6f },
+        { Cell::Stone, "stone", MovementClass::Solid,  2.6f },
+        { Cell::Wood,  "wood",  MovementClass::Solid,  0.7f },
+        { Cell::Water, "water", MovementClass::Liquid, 1.0f },
+        { Cell::Fire,  "fire",  MovementClass::Solid,  0.0f },
+        { Cell::Smoke, "smoke", MovementClass::Gas,    0.1f },
+    };
+
+    std::optional<MovementClass> parse_movement(const std::string& value)
+    {
+        if (value == "none")   return MovementClass::None;
+        if (value == "solid")  return MovementClass::Solid;
+        if (value == "powder") return MovementClass::Powder;
+        if (value == "liquid") return MovementClass::Liquid;
+        if (value == "gas")    return MovementClass::Gas;
+
+        return std::nullopt;
+    }
+
+    std::optional<Colour> parse_colour(const std::string& value)
+    {
+        std::istringstream stream(value);
+        int channels[4] = { 0, 0, 0, 255 };
+        int count = 0;
+
+        while (count < 4 && stream >> channels[count]) count++;
+
+        if (count < 3 || !(stream >> std::ws).eof()) return std::nullopt;
+        if (std::any_of(channels, channels + 4, [](int c) { return c < 0 || c > 255; })) return std::nullopt;
+
+        return Colour(channels[0], channels[1], channels[2], channels[3]);
+    }
+
+    std::string trim(const std::string& text)
+    {
+        const size_t start = text.find_first_not_of(" \t\r");
+
+        if (start == std::string::npos) return "";
+
+        return text.substr(start, text.find_last_not_of(" \t\r") - start + 1);
+    }
+}
+
+const Cell& Cell::get_default(CellType type)
+{
+    return MaterialRegistry::get().get_default(type);
+}
+
+MaterialRegistry::MaterialRegistry()
+{
+    for (const BuiltinMaterial& builtin : c_builtin_materials)
+    {
+        Material& material = m_materials[static_cast<int>(builtin.cell.type)];
+
+        material.name = builtin.name;
+        material.movement = builtin.movement;
+        material.density = builtin.density;
+        material.life_time = builtin.cell.life_time;
+        material.colour = builtin.cell.colour;
+        material.colour_max = builtin.cell.colour;
+    }
+
+    rebuild_tables();
+}
+
+MaterialRegistry& MaterialRegistry::get()
+{
+    static MaterialRegistry registry;
+
+    return registry;
+}
+
+const Material& MaterialRegistry::get_material(CellType type) const
+{
+    return m_materials[static_cast<int>(type)];
+}
+
+const Cell& MaterialRegistry::get_default(CellType type) const
+{
+    return m_defaults[static_cast<int>(type)];
+}
+
+std::optional<CellType> MaterialRegistry::find(std::string_view name) const
+{
+    for (int i = 0; i < c_max_materials; i++)
+    {
+        if (!m_materials[i].name.empty() && m_materials[i].name == name) return static_cast<CellType>(i);
+    }
+
+    return std::nullopt;
+}
+
+void MaterialRegistry::set_material(CellType type, const Material& material)
+{
+    assert(type != CellType::Empty && "MaterialRegistry::set_material empty cant be changed!");
+
+    m_materials[static_cast<int>(type)] = material;
+
+    rebuild_tables();
+}
+
+Cell MaterialRegistry::make_cell(CellType type, uint32_t random) const
+{
+    const Material& material = get_material(type);
+    Cell cell = get_default(type);
+
+    // one blend factor for all channels keeps the colour on the line between the two
+    const int t = random & 0xFF;
+    const auto blend = [t](uint8_t from, uint8_t to) { return static_cast<uint8_t>(from + (to - from) * t / 255); };
+
+    cell.colour = {
+        blend(material.colour.r, material.colour_max.r),
+        blend(material.colour.g, material.colour_max.g),
+        blend(material.colour.b, material.colour_max.b),
+        blend(material.colour.a, material.colour_max.a),
+    };
+
+    return cell;
+}
+
+bool MaterialRegistry::load(std::istream& stream, std::string* error)
+{
+    // parse into a copy so a broken file changes nothing
+    MaterialRegistry loaded = *this;
+
+    std::string line;
+    int line_number = 0;
+    Material* material = nullptr;
+
+    const auto fail = [&](const std::string& message)
+    {
+        if (error != nullptr) *error = "line " + std::to_string(line_number) + ": " + message;
+
+        return false;
+    };
+
+    while (std::getline(stream, line))
+    {
+        line_number++;
+        line = trim(line.substr(0, line.find('#')));
+
+        if (line.empty()) continue;
+
+        // [name] starts a material, an existing name changes that material
+        if (line.front() == '[')
+        {
+            if (line.back() != ']') return fail("unclosed section");
+
+            const std::string name = trim(line.substr(1, line.size() - 2));
+            const std::optional<CellType> type = loaded.find(name);
+
+            if (name.empty()) return fail("material without a name");
+            if (type == CellType::Empty) return fail("empty cant be changed");
+
+            material = nullptr;
+
+            if (type)
+            {
+                material = &loaded.m_materials[static_cast<int>(*type)];
+            }
+            else 
+            {
+                // a new material takes the first free id
+                for (int i = 1; i < c_max_materials && material == nullptr; i++)
+                {
+                    if (loaded.m_materials[i].name.empty()) material = &loaded.m_materials[i];
+                }
+
+                if (material == nullptr) return fail("too many materials");
+
+                *material = Material();
+                material->name = name;
+                material->movement = MovementClass::Solid;
+            }
+
+            continue;
+        }
+
+        const size_t equals = line.find('=');
+
+        if (material == nullptr) return fail("value outside of a material");
+        if (equals == std::string::npos) return fail("expected key = value");
+
+        const std::string key = trim(line.substr(0, equals));
+        const std::string value = trim(line.substr(equals + 1));
+        std::istringstream value_stream(value);
+
+        if (key == "movement")
+        {
+            const std::optional<MovementClass> movement = parse_movement(value);
+
+            if (!movement || movement == MovementClass::None) return fail("unknown movement " + value);
+
+            material->movement = *movement;
+        }
+        else if (key == "density")
+        {
+            if (!(value_stream >> material->density)) return fail("bad density");
+        }
+        else if (key == "dispersion")
+        {
+            if (!(value_stream >> material->dispersion) || material->dispersion < 1 || material->dispersion > c_max_dispersion)
+            {
+                return fail("dispersion has to be between 1 and " + std::to_string(c_max_dispersion));
+            }
+        }
+        else if (key == "max_speed")
+        {
+            if (!(value_stream >> material->max_speed) || material->max_speed < 1 || material->max_speed > c_max_speed)
+            {
+                return fail("max_speed has to be between 1 and " + std::to_string(c_max_speed));
+            }
+        }
+        else if (key == "life_time")
+        {
+            if (!(value_stream >> material->life_time)) return fail("bad life_time");
+        }
+        else if (key == "colour" || key == "colour_max")
+        {
+            const std::optional<Colour> colour = parse_colour(value);
+
+            if (!colour) return fail("colour needs 3 or 4 values from 0 to 255");
+
+            // a single colour is also the whole range
+            if (key == "colour") material->colour = material->colour_max = *colour;
+            else                 material->colour_max = *colour;
+        }
+        else 
+        {
+            return fail("unknown key " + key);
+        }
+    }
+
+    loaded.rebuild_tables();
+    *this = std::move(loaded);
+
+    return true;
+}
+
+bool MaterialRegistry::load_from_file(const std::filesystem::path& path, std::string* error)
+{
+    std::ifstream file(path);
+
+    if (!file)
+    {
+        if (error != nullptr) *error = "cant open " + path.string();
+
+        return false;
+    }
+
+    return load(file, error);
+}
+
+void MaterialRegistry::rebuild_tables()
+{
+    for (int i = 0; i < c_max_materials; i++)
+    {
+        const Material& material = m_materials[i];
+
+        m_defaults[i] = Cell(static_cast<CellType>(i), material.colour, material.life_time);
+    }
+
+    // falling movers sink through lighter liquids and gases, rising gases through heavier ones
+    for (int mover = 0; mover < c_max_materials; mover++)
+    {
+        const Material& moving = m_materials[mover];
+
+        m_displaces[mover].reset();
+        m_displaces[mover][static_cast<int>(CellType::Empty)] = moving.movement != MovementClass::None;
+
+        if (moving.movement == MovementClass::None || moving.movement == MovementClass::Solid) continue;
+
+        for (int target = 1; target < c_max_materials; target++)
+        {
+            const Material& other = m_materials[target];
+
+            if (target == mover) continue;
+            if (other.movement != MovementClass::Liquid && other.movement != MovementClass::Gas) continue;
+
+            m_displaces[mover][target] = moving.movement == MovementClass::Gas ? 
+                moving.density < other.density : 
+                moving.density > other.density;
+        }
+    }
+
+    // falls straight down or rests on what is under it
+    m_fall_table.clear();
+
+    for (int type = 0; type < c_max_materials; type++)
+    {
+        const MovementClass movement = m_materials[type].movement;
+        uint8_t flags = 0;
+
+        // a bulk move cant carry a life time, those cells fall one at a time
+        const bool ages = m_materials[type].life_time >= 0;
+
+        if (movement == MovementClass::Powder && !ages) flags |= c_falls_as_powder;
+        if (movement == MovementClass::Liquid && !ages) flags |= c_falls_as_liquid;
+
+        // unused types stay without flags so the table fits the vector paths
+        bool blocks = type != static_cast<int>(CellType::Empty) && !m_materials[type].name.empty();
+
+        for (int mover = 0; mover < c_max_materials && blocks; mover++)
+        {
+            const MovementClass mover_movement = m_materials[mover].movement;
+
+            if (mover_movement != MovementClass::Powder && mover_movement != MovementClass::Liquid) continue;
+
+            blocks = !m_displaces[mover][type];
+        }
+
+        if (blocks) flags |= c_blocks_falling;
+
+        m_fall_table.set_flags(static_cast<uint8_t>(type), flags);
+    }
+}
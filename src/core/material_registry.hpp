@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "core/cell.hpp"
+#include "utils/byte_classifier.hpp"
+#include "utils/colour.hpp"
+
+enum class MovementClass : uint8_t
+{
+    None = 0, // empty space
+    Solid,
+    Powder,
+    Liquid,
+    Gas,
+};
+
+struct Material
+{
+    std::string name;
+    MovementClass movement = MovementClass::None;
+    float density = 0;      // heavier powders and liquids sink through lighter liquids and gases
+    int dispersion = 1;     // cells a liquid or gas can spread sideways in a step
+    int max_speed = 8;      // cells a falling or rising cell can cover in a step once it sped up
+    float life_time = -1;   // seconds, -1 lives forever
+    Colour colour = Colour::Blank;     // default colour and the start of the range
+    Colour colour_max = Colour::Blank; // new cells pick a colour between colour and colour_max
+};
+
+// every material indexed by its cell type, built in materials are registered up front
+// and can be changed or extended by a config file before the simulation starts
+class MaterialRegistry
+{
+public:
+    MaterialRegistry();
+
+    // the registry chunks and updaters read from
+    static MaterialRegistry& get();
+
+    const Material& get_material(CellType type) const;
+    const Cell& get_default(CellType type) const;
+    std::optional<CellType> find(std::string_view name) const;
+
+    void set_material(CellType type, const Material& material);
+
+    // a cell with its colour picked from the range
+    Cell make_cell(CellType type, uint32_t random) const;
+
+    // true if a moving cell can swap places with the target
+    bool can_displace(CellType mover, CellType target) const
+    {
+        return m_displaces[static_cast<int>(mover)][static_cast<int>(target)];
+    }
+
+    // what the bulk gravity pass needs to know about every cell type, see the flags below
+    const ByteClassifier& get_fall_table() const { return m_fall_table; }
+
+    // sections of key = value lines, see assets/materials.cfg, the registry is left alone if anything is wrong
+    bool load(std::istream& stream, std::string* error = nullptr);
+    bool load_from_file(const std::filesystem::path& path, std::string* error = nullptr);
+
+public:
+    static constexpr int c_max_materials = 256;
+    // workers can only move cells a few cells past their chunk
+    static constexpr int c_max_dispersion = 8;
+    static constexpr int c_max_speed = 8;
+
+    // flags in the fall table, types with a default life time never fall in bulk
+    static constexpr uint8_t c_falls_as_powder = 1 << 0;
+    static constexpr uint8_t c_falls_as_liquid = 1 << 1;
+    static constexpr uint8_t c_blocks_falling = 1 << 2; // filled and no powder or liquid can displace it
+
+private:
+    void rebuild_tables();
+
+private:
+    std::array<Material, c_max_materials> m_materials;
+    std::array<Cell, c_max_materials> m_defaults;
+    std::array<std::bitset<c_max_materials>, c_max_materials> m_displaces;
+    ByteClassifier m_fall_table;
+};
@@ -0,0 +1,136 @@
+#include "generation/cave_gen.hpp"
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    struct BitSum
+    {
+        uint64_t sum = 0;
+        uint64_t carry = 0;
+    };
+
+    // one bit adders for 64 cells side by side
+    BitSum add(uint64_t a, uint64_t b)
+    {
+        return { a ^ b, a & b };
+    }
+
+    BitSum add(uint64_t a, uint64_t b, uint64_t c)
+    {
+        return { a ^ b ^ c, (a & b) | (c & (a ^ b)) };
+    }
+}
+
+CaveGen::CaveGen(uint64_t seed, int fill_percent, int smooth_steps) : m_random(seed), m_fill_percent(fill_percent), m_smooth_steps(smooth_steps)
+{
+    assert(fill_percent >= 0 && fill_percent <= 100 && "CaveGen::CaveGen fill percent out of range!");
+    assert(smooth_steps >= 0 && smooth_steps <= 31 && "CaveGen::CaveGen too many smooth steps!");
+}
+
+void CaveGen::generate(int min_x, int min_y, int width, int height, std::span<uint64_t> solid, std::span<uint64_t> sand) const
+{
+    assert(width > 0 && width <= 64 && height > 0 && "CaveGen::generate size out of range!");
+    assert(solid.size() >= static_cast<size_t>(height) && sand.size() >= static_cast<size_t>(height) && "CaveGen::generate rows too small!");
+
+    // each smooth step lets a cell see one cell further, the sand needs the row above and below as well
+    // whatever is wrong at the edges of the padding never reaches the middle
+    const int pad = m_smooth_steps + 1;
+    const int padded_width = width + pad * 2;
+    const int padded_height = height + pad * 2;
+
+    std::vector<Row> current(padded_height);
+    std::vector<Row> next(padded_height);
+
+    for (int y = 0; y < padded_height; y++)
+    {
+        for (int x = 0; x < padded_width; x++)
+        {
+            if (is_solid_noise(min_x - pad + x, min_y - pad + y)) current[y][x / 64] |= uint64_t(1) << (x % 64);
+        }
+    }
+
+    for (int step = 0; step < m_smooth_steps; step++)
+    {
+        smooth(current, next);
+        std::swap(current, next);
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint64_t above = extract(current[y + pad - 1], pad, width);
+        const uint64_t row = extract(current[y + pad], pad, width);
+        const uint64_t below = extract(current[y + pad + 1], pad, width);
+
+        // a layer of sand on top of rock that has air above it
+        solid[y] = row;
+        sand[y] = row & ~above & below;
+    }
+}
+
+bool CaveGen::is_solid_noise(int x, int y) const
+{
+    return static_cast<int>(m_random.get({ x, y }, 0) % 100) < m_fill_percent;
+}
+
+void CaveGen::smooth(std::span<const Row> current, std::span<Row> next)
+{
+    const int row_count = static_cast<int>(current.size());
+
+    // the first and last row have no neighbours on one side, they are padding anyway
+    next.front() = current.front();
+    next.back() = current.back();
+
+    for (int y = 1; y + 1 < row_count; y++)
+    {
+        for (int w = 0; w < c_row_words; w++)
+        {
+            // the neighbours of every cell in the word, shifted so they line up with it
+            uint64_t neighbours[8];
+            int count = 0;
+
+            for (int offset_y = -1; offset_y <= 1; offset_y++)
+            {
+                const Row& row = current[y + offset_y];
+
+                neighbours[count++] = (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+                neighbours[count++] = (row[w] >> 1) | (w + 1 < c_row_words ? row[w + 1] << 63 : 0);
+
+                if (offset_y != 0) neighbours[count++] = row[w];
+            }
+
+            // count them in binary, a bit per cell in each of the four digits
+            const BitSum a = add(neighbours[0], neighbours[1], neighbours[2]);
+            const BitSum b = add(neighbours[3], neighbours[4], neighbours[5]);
+            const BitSum c = add(neighbours[6], neighbours[7]);
+            const BitSum ones = add(a.sum, b.sum, c.sum);
+            const BitSum twos_abc = add(a.carry, b.carry, c.carry);
+            const BitSum twos = add(twos_abc.sum, ones.carry);
+
+            const uint64_t bit0 = ones.sum;
+            const uint64_t bit1 = twos.sum;
+            const uint64_t bit2 = twos_abc.carry ^ twos.carry;
+            const uint64_t bit3 = twos_abc.carry & twos.carry;
+
+            // more than four rock neighbours turns a cell to rock, fewer to air, exactly four keeps it
+            const uint64_t more_than_four = bit3 | (bit2 & (bit1 | bit0));
+            const uint64_t exactly_four = bit2 & ~bit3 & ~bit1 & ~bit0;
+
+            next[y][w] = more_than_four | (exactly_four & current[y][w]);
+        }
+    }
+}
+
+uint64_t CaveGen::extract(const Row& row, int offset, int width)
+{
+    const int word = offset / 64;
+    const int shift = offset % 64;
+
+    uint64_t bits = row[word] >> shift;
+
+    if (shift != 0 && word + 1 < c_row_words) bits |= row[word + 1] << (64 - shift);
+
+    return width == 64 ? bits : bits & ((uint64_t(1) << width) - 1);
+}
@@ -1,135 +1,64 @@
 #pragma once
 
 #include <array>
-#include <random>
+#include <bit>
+#include <cstdint>
+#include <span>
 
-#include <raylib.h>
-
-#include "core/chunk_context.hpp"
+#include "core/cell.hpp"
+#include "utils/point.hpp"
+#include "utils/counter_random.hpp"
 
+// caves from smoothed noise, every cell is a pure function of the seed and its position
+// so chunks generated one at a time or all at once, in any order, line up without seams
+// rows are bit packed, the smoothing counts neighbours for 64 cells at a time with bitwise adds
 class CaveGen
 {
 public:
-    CaveGen()
-    {
-        m_texture = LoadRenderTexture(c_width * 8, c_height * 8);
-    }
+    explicit CaveGen(uint64_t seed = 0, int fill_percent = 48, int smooth_steps = 4);
 
-    ~CaveGen()
-    {
-        UnloadRenderTexture(m_texture);
-    }
+    // bit x of solid[y] is set if cell (min_x + x, min_y + y) is rock, sand is the part of it lying on a cave floor
+    // width is at most 64
+    void generate(int min_x, int min_y, int width, int height, std::span<uint64_t> solid, std::span<uint64_t> sand) const;
 
-    void reset()
-    {
-        m_current.fill(0);
-        //m_next.fill(0);
-    }
-
-    void generate_map()
-    {
-        add_noise();
+    // fills a chunk that was just created with stone and sand
+    template<typename ChunkType>
+    void fill_chunk(Point chunk_position, ChunkType& chunk) const;
 
-        for (int i = 0; i < m_smooth_iter; i++)
-        {
-            smooth_map();
-        }
+private:
+    // a padded row, the chunk plus enough cells on each side to smooth its edges like the neighbours do
+    static constexpr int c_row_words = 2;
 
-        BeginTextureMode(m_texture);
-        ClearBackground(BLANK);
+    using Row = std::array<uint64_t, c_row_words>;
 
-        for (int x = 0; x < c_width; x++)
-        {
-            for (int y = 0; y < c_height; y++)
-            {
-                if (m_current[x + y * c_width] == 1)
-                {
-                    DrawRectangle(x * 8, y * 8, 8, 8, WHITE);
-                }
-            }
-        }
+    bool is_solid_noise(int x, int y) const;
 
-        EndTextureMode();
-    }
-
-    void draw()
-    {
-        DrawTexture(m_texture.texture, 0, 0, WHITE);
-    }
+    static void smooth(std::span<const Row> current, std::span<Row> next);
+    static uint64_t extract(const Row& row, int offset, int width);
 
 private:
-    void add_noise()
-    {
-        static std::random_device seed;
-        static std::mt19937 gen(seed());
-        std::uniform_int_distribution<> dist{0, 100};
-        std::uniform_int_distribution<> fill_percent{30, 60};
-
-        for (int x = 0; x < c_width; x++)
-        {
-            for (int y = 0; y < c_height; y++)
-            {
-                m_current[x + y * c_width] = dist(gen) > fill_percent(gen) ? 1 : 0;
-            }
-        }
-    }
+    CounterRandom m_random;
+    int m_fill_percent = 48;
+    int m_smooth_steps = 4;
+};
 
-    int get_neighour_count(int x, int y)
-    {
-        int count = 0;
+template<typename ChunkType>
+void CaveGen::fill_chunk(Point chunk_position, ChunkType& chunk) const
+{
+    using Context = typename ChunkType::ContextType;
 
-        for (int n_x = x - 1; n_x <= x + 1; n_x++)
-        {
-            for (int n_y = y - 1; n_y <= y + 1; n_y++)
-            {
-                if (n_x >= 0 && n_x < c_width && n_y >= 0 && n_y < c_height)
-                {
-                    if (n_x != x || n_y != y )
-                    {
-                        count += m_current[n_x + n_y * c_width];
-                    }
-                }
-            }
-        }
+    std::array<uint64_t, Context::height> solid;
+    std::array<uint64_t, Context::height> sand;
 
-        return count;
-    }
+    generate(chunk_position.x * Context::width, chunk_position.y * Context::height, Context::width, Context::height, solid, sand);
 
-    void smooth_map()
+    for (int y = 0; y < Context::height; y++)
     {
-        for (int x = 0; x < c_width; x++)
+        for (uint64_t cells = solid[y]; cells != 0; cells &= cells - 1)
         {
-            for (int y = 0; y < c_height; y++)
-            {
-                int neighourTiles = get_neighour_count(x, y);
+            const int x = std::countr_zero(cells);
 
-                if (neighourTiles > 4)
-                {
-                    m_current[x + y * c_width] = 1;
-                }
-                else if (neighourTiles < 4)
-                {
-                    m_current[x + y * c_width] = 0;
-                }
-                else
-                {
-                    //m_next[x + y * c_width] = m_current[x + y * c_width];
-                }
-            }
+            chunk.set_cell(Point(x, y), (sand[y] >> x) & 1 ? Cell::Sand : Cell::Stone);
         }
-
-        //m_current = m_next;
-        //m_next.fill(0);
     }
-
-private:
-    static constexpr int c_width = ChunkContext::width;
-    static constexpr int c_height = ChunkContext::height;
-
-private:
-    int m_smooth_iter = 3; // 4
-    //int m_random_fill_percent = 34; // 48
-    //std::array<int, c_width * c_height> m_next;
-    std::array<int, c_width * c_height> m_current;
-    RenderTexture2D m_texture;
-};
\ No newline at end of file
+}
@@ -1,24 +1,94 @@
 #include <raylib.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+
 #include "core/cell.hpp"
+#include "core/material_registry.hpp"
 #include "simulation/chunk_manager.hpp"
+#include "simulation/simulation_thread.hpp"
+#include "simulation/snapshot_saver.hpp"
 #include "core/chunk_updater.hpp"
+#include "generation/cave_gen.hpp"
+#include "rendering/chunk_renderer.hpp"
+#include "utils/trace.hpp"
+
+// what the overlay shows from the manager, read while no update is running
+struct SandboxStats
+{
+    size_t total_chunks = 0;
+    ChunkPoolStats pool_stats;
+    float step_rate = 0;
+    uint64_t dropped_steps = 0;
+};
 
-void input(ChunkManager& sandbox, Cell& current_cell, Camera2D& camera, Vector2& movement, bool& debug_mode, float frame_time)
+// called while no update is running, so the manager can be used directly
+void input(ChunkManager& sandbox, SimulationThread& simulation, SnapshotSaver& saver, CellType& current_type, Camera2D& camera, Vector2& movement, bool& debug_mode, bool& pipelined, float frame_time)
 {
     const int brush_radius = 2;
+    const char* snapshot_path = "sandbox.snapshot";
 
     if (IsKeyDown(KEY_D)) movement.x += 512.0f * frame_time;
     if (IsKeyDown(KEY_A)) movement.x -= 512.0f * frame_time;
     if (IsKeyDown(KEY_W)) movement.y -= 512.0f * frame_time;
     if (IsKeyDown(KEY_S)) movement.y += 512.0f * frame_time;
     
-    if (IsKeyPressed(KEY_ONE))   current_cell = Cell::Sand;
-    if (IsKeyPressed(KEY_TWO))   current_cell = Cell::Water;
-    if (IsKeyPressed(KEY_THREE)) current_cell = Cell::Stone;
-    if (IsKeyPressed(KEY_FOUR)) current_cell = Cell::Smoke;
+    const MaterialRegistry& materials = MaterialRegistry::get();
+
+    if (IsKeyPressed(KEY_ONE))   current_type = CellType::Sand;
+    if (IsKeyPressed(KEY_TWO))   current_type = CellType::Water;
+    if (IsKeyPressed(KEY_THREE)) current_type = CellType::Stone;
+    if (IsKeyPressed(KEY_FOUR))  current_type = CellType::Smoke;
+    if (IsKeyPressed(KEY_FIVE))  current_type = materials.find("oil").value_or(current_type);
+
+    if (IsKeyPressed(KEY_F1)) 
+    {
+        debug_mode = !debug_mode;
+
+        // only pay for metrics while they are shown
+        sandbox.get_metrics().set_enabled(debug_mode);
+    }
+
+    // fewer steps per second keeps a busy world running at full speed with less detail
+    const float step_rate = 1.0f / sandbox.get_time_step();
+
+    if (IsKeyPressed(KEY_MINUS)) sandbox.set_step_rate(std::max(step_rate - 15.0f, 15.0f));
+    if (IsKeyPressed(KEY_EQUAL)) sandbox.set_step_rate(std::min(step_rate + 15.0f, 120.0f));
+
+    // only does something in a build with SAND_TRACING
+    if (IsKeyPressed(KEY_F2)) TRACE_WRITE("sandbox_trace.json");
+
+    // quick save runs in the background, loading waits for it first
+    // pipelined the saver copies the snapshot being drawn
+    if (IsKeyPressed(KEY_F5))
+    {
+        if (pipelined) saver.save(simulation.get_snapshot(), snapshot_path);
+        else           saver.save(sandbox, snapshot_path);
+    }
+
+    if (IsKeyPressed(KEY_F9))
+    {
+        saver.wait();
+        SnapshotSaver::load(sandbox, snapshot_path);
+    }
+
+    // simulate the next step on another thread while this one is drawn
+    if (IsKeyPressed(KEY_P))
+    {
+        pipelined = !pipelined;
 
-    if (IsKeyPressed(KEY_F1)) debug_mode = !debug_mode;
+        // drawing straight from the manager used up its changed rects, start over with full copies
+        if (pipelined) simulation.get_snapshot().clear();
+    }
+
+    // pipelined edits are queued and go in right before the next update starts
+    const auto paint = [&](int x, int y, const Cell& cell)
+    {
+        if (pipelined) simulation.set_cell(x, y, cell);
+        else           sandbox.set_cell(x, y, cell);
+    };
 
     if (IsMouseButtonDown(0))
     {
@@ -29,7 +99,10 @@ void input(ChunkManager& sandbox, Cell& current_cell, Camera2D& camera, Vector2&
         {
             for (int x = -brush_radius; x <= brush_radius; x++)
             {
-                sandbox.set_cell(gx + x, gy + y, current_cell);
+                // every cell gets its own shade from the material colour range
+                const uint32_t random = CounterRandom(sandbox.get_step()).get({ gx + x, gy + y }, 0);
+
+                paint(gx + x, gy + y, materials.make_cell(current_type, random));
             }
         }
     }
@@ -42,7 +115,7 @@ void input(ChunkManager& sandbox, Cell& current_cell, Camera2D& camera, Vector2&
         {
             for (int x = -brush_radius; x <= brush_radius; x++)
             {
-                sandbox.set_cell(gx + x, gy + y, Cell());
+                paint(gx + x, gy + y, Cell());
             }
         }
     }
@@ -63,7 +136,61 @@ Rectangle handle_camera_view(const Camera2D& camera)
     };
 }
 
-void update_sandbox(ChunkManager& manager, const Camera2D& camera, bool debug_mode, float frame_time)
+SandboxStats get_stats(const ChunkManager& manager)
+{
+    return {
+        manager.get_total_chunks(),
+        manager.get_pool_stats(),
+        1.0f / manager.get_time_step(),
+        manager.get_dropped_steps(),
+    };
+}
+
+void draw_metrics(const MetricsSummary& summary, int y)
+{
+    const StepMetrics& average = summary.average;
+    const StepMetrics& peak = summary.peak;
+
+    const char* phase_names[] = { "Update", "Apply Moves", "Particles", "Update Rect", "Remove Chunks", "Pre Draw" };
+
+    // average and worst step over the window
+    for (int i = 0; i < static_cast<int>(MetricPhase::Count); i++)
+    {
+        const MetricPhase phase = static_cast<MetricPhase>(i);
+
+        DrawText(TextFormat("%s: %.3f ms (max %.3f)", phase_names[i], average.get_phase_ms(phase), peak.get_phase_ms(phase)), 0, y, 20, GREEN);
+        y += 20;
+    }
+
+    DrawText(TextFormat("Cells Visited: %llu Moves: %llu Dropped: %llu", 
+        (unsigned long long)average.cells_visited, (unsigned long long)average.moves_queued, (unsigned long long)average.moves_dropped), 0, y, 20, GREEN);
+    DrawText(TextFormat("Chunks Awake: %llu Asleep: %llu Tiles Awake: %llu Created: %llu Destroyed: %llu (last %d steps)", 
+        (unsigned long long)average.chunks_awake, (unsigned long long)average.chunks_asleep, (unsigned long long)average.tiles_awake, 
+        (unsigned long long)summary.total.chunks_created, (unsigned long long)summary.total.chunks_destroyed, summary.steps), 0, y + 20, 20, GREEN);
+    DrawText(TextFormat("Particles: %llu Landed: %llu Steps Dropped: %llu", 
+        (unsigned long long)average.particles, (unsigned long long)average.particles_landed, (unsigned long long)summary.total.steps_dropped), 0, y + 40, 20, GREEN);
+}
+
+void draw_overlay(const SandboxStats& stats, const MetricsSummary& summary, bool debug_mode, bool pipelined)
+{
+    // global draw information
+    DrawFPS(0, 0);
+    DrawText(TextFormat("FrameTime: %.5f%s", GetFrameTime() * 1000, pipelined ? " (pipelined)" : ""), 0, 20, 20, RED);
+    DrawText(TextFormat("Chunks Active: %zu Step Rate: %.0f Dropped: %llu", 
+        stats.total_chunks, stats.step_rate, (unsigned long long)stats.dropped_steps), 0, 40, 20, GREEN);
+
+    if (debug_mode)
+    {
+        const ChunkPoolStats& pool_stats = stats.pool_stats;
+
+        DrawText(TextFormat("Chunks Created: %zu Reused: %zu Retired: %zu Pooled: %zu", 
+            pool_stats.created, pool_stats.reused, pool_stats.retired, pool_stats.pooled), 0, 60, 20, GREEN);
+
+        draw_metrics(summary, 80);
+    }
+}
+
+void update_sandbox(ChunkManager& manager, ChunkRenderer& renderer, const Camera2D& camera, bool debug_mode, float frame_time)
 {
     auto view = handle_camera_view(camera);
 
@@ -74,17 +201,40 @@ void update_sandbox(ChunkManager& manager, const Camera2D& camera, bool debug_mo
     ClearBackground(BLANK);
 
     // set up chunks
-    manager.pre_draw(view);
+    renderer.pre_draw(manager, view);
 
     // within camera, draw chunks
     BeginMode2D(camera);
-    manager.draw(view, debug_mode);
+    renderer.draw(manager, view, debug_mode);
     EndMode2D();
 
-    // global draw information
-    DrawFPS(0, 0);
-    DrawText(TextFormat("FrameTime: %.5f", GetFrameTime() * 1000), 0, 20, 20, RED);
-    DrawText(TextFormat("Chunks Active: %d", manager.get_total_chunks()), 0, 40, 20, GREEN);
+    draw_overlay(get_stats(manager), debug_mode ? manager.get_metrics().get_summary() : MetricsSummary(), debug_mode, false);
+
+    EndDrawing();
+}
+
+void update_pipelined(ChunkManager& manager, SimulationThread& simulation, ChunkRenderer& renderer, const Camera2D& camera, bool debug_mode, float frame_time)
+{
+    auto view = handle_camera_view(camera);
+
+    // the last chance to read the manager before the next update starts
+    const SandboxStats stats = get_stats(manager);
+
+    // the next step runs in the background while the last one is drawn
+    simulation.advance<ChunkUpdater>(frame_time);
+
+    WorldSnapshot& snapshot = simulation.get_snapshot();
+
+    BeginDrawing();
+    ClearBackground(BLANK);
+
+    renderer.pre_draw(snapshot, view);
+
+    BeginMode2D(camera);
+    renderer.draw(snapshot, view, debug_mode);
+    EndMode2D();
+
+    draw_overlay(stats, snapshot.get_metrics_summary(), debug_mode, true);
 
     EndDrawing();
 }
@@ -93,9 +243,30 @@ int main()
 {
     InitWindow(1280, 720, "Pixel Physics");
 
-    ChunkManager sandbox;
+    // materials can be tuned without rebuilding, the built in ones are used if the file is missing or broken
+    std::string material_error;
+
+    if (!MaterialRegistry::get().load_from_file("materials.cfg", &material_error))
+    {
+        std::fprintf(stderr, "materials.cfg: %s\n", material_error.c_str());
+    }
+
+    ChunkManager sandbox(std::thread::hardware_concurrency());
+
+    // a slow frame is allowed to cost at most a few steps and most of a frame of work, the rest is dropped
+    sandbox.set_catch_up_limits(4, 1.0f / 30.0f);
+
+    // the whole world starts out as caves
+    const CaveGen caves(sandbox.get_seed());
+    sandbox.set_generator([&caves](Point chunk_position, Chunk& chunk) { caves.fill_chunk(chunk_position, chunk); });
+    sandbox.generate_chunks(ChunkContext::min_chunk_pos, ChunkContext::max_chunk_pos);
+
+    ChunkRenderer renderer;
+    SimulationThread simulation(sandbox);
+    SnapshotSaver saver;
     bool debug_mode = false;
-    Cell current_cell;
+    bool pipelined = true;
+    CellType current_type = CellType::Empty;
 
     Vector2 movement = { 
         -(1280.0f / 2.0f),
@@ -112,9 +283,13 @@ int main()
     {
         float frame_time = GetFrameTime();
 
-        input(sandbox, current_cell, camera, movement, debug_mode, frame_time);
+        // the manager is free once the update started last frame finished
+        simulation.wait();
+
+        input(sandbox, simulation, saver, current_type, camera, movement, debug_mode, pipelined, frame_time);
 
-        update_sandbox(sandbox, camera, debug_mode, frame_time);
+        if (pipelined) update_pipelined(sandbox, simulation, renderer, camera, debug_mode, frame_time);
+        else           update_sandbox(sandbox, renderer, camera, debug_mode, frame_time);
     }
 
     CloseWindow();
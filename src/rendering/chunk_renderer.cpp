@@ -0,0 +1,269 @@
+#include "rendering/chunk_renderer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+
+#include "utils/trace.hpp"
+
+ChunkRenderer::~ChunkRenderer()
+{
+    for (auto& [position, chunk_view] : m_views)
+    {
+        UnloadTexture(chunk_view.texture);
+    }
+}
+
+void ChunkRenderer::pre_draw(ChunkManager& manager, const Rectangle& view)
+{
+    ScopedPhaseTimer timer(manager.get_metrics(), MetricPhase::PreDraw);
+
+    prepare_views(manager.get_chunks(), view);
+}
+
+void ChunkRenderer::draw(const ChunkManager& manager, const Rectangle& view, bool debug) const
+{
+    draw_chunks(manager.get_chunks(), manager.get_particles(), view, debug);
+}
+
+void ChunkRenderer::pre_draw(WorldSnapshot& snapshot, const Rectangle& view)
+{
+    // the manager's metrics belong to the simulation thread now, the snapshot hands the time over on the next capture
+    const auto start = std::chrono::steady_clock::now();
+
+    prepare_views(snapshot.get_chunks(), view);
+
+    snapshot.add_pre_draw_time(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+void ChunkRenderer::draw(const WorldSnapshot& snapshot, const Rectangle& view, bool debug) const
+{
+    draw_chunks(snapshot.get_chunks(), snapshot.get_particles(), view, debug);
+}
+
+size_t ChunkRenderer::get_total_textures() const
+{
+    return m_views.size();
+}
+
+void ChunkRenderer::prepare_views(std::span<Chunk* const> chunks, const Rectangle& view)
+{
+    TRACE_SCOPE("pre_draw");
+
+    for (auto& [position, chunk_view] : m_views)
+    {
+        chunk_view.visible = false;
+    }
+
+    // prepare all active chunks in view
+    for (auto* chunk : chunks)
+    {
+        assert(chunk != nullptr);
+
+        if (!is_chunk_in_view(chunk, view)) continue;
+
+        TRACE_SCOPE_CHUNK("pre_draw_chunk", ChunkContext::cell_to_chunk(chunk->get_position().x / c_cell_size, chunk->get_position().y / c_cell_size));
+
+        auto [it, inserted] = m_views.try_emplace(chunk->get_position());
+        ChunkView& chunk_view = it->second;
+
+        // attach a texture the first time a chunk becomes visible
+        if (inserted)
+        {
+            Image image = GenImageColor(c_width, c_height, BLANK);
+            chunk_view.texture = LoadTextureFromImage(image);
+            UnloadImage(image);
+
+            update_pixels(chunk, chunk_view.pixels, { 0, 0, c_width - 1, c_height - 1 });
+        }
+        else 
+        {
+            // only the cells that were set since the last frame, new chunks count as fully changed
+            update_pixels(chunk, chunk_view.pixels, chunk->get_changed_rect());
+        }
+
+        upload_pixels(chunk_view);
+        chunk->clear_changed_rect();
+
+        chunk_view.visible = true;
+    }
+
+    // chunks that were removed or left the view give their texture back
+    release_hidden_views();
+}
+
+void ChunkRenderer::draw_chunks(std::span<Chunk* const> chunks, const ParticleSystem& particles, const Rectangle& view, bool debug) const
+{
+    // draw all active chunks in view
+    for (const auto* chunk : chunks)
+    {
+        assert(chunk != nullptr);
+
+        if (!is_chunk_in_view(chunk, view)) continue;
+
+        // chunk was created after pre_draw, it will show up next frame
+        auto it = m_views.find(chunk->get_position());
+        if (it == m_views.end()) continue;
+
+        draw_chunk(chunk, it->second, debug);
+    }
+
+    draw_particles(particles, view);
+}
+
+bool ChunkRenderer::is_chunk_in_view(const Chunk* chunk, const Rectangle& view) const
+{
+    const Point position = chunk->get_position();
+    const Point size = { c_width * c_cell_size, c_height * c_cell_size };
+    const Rectangle chunkRect = {
+        static_cast<float>(position.x),
+        static_cast<float>(position.y),
+        static_cast<float>(size.x),
+        static_cast<float>(size.y)
+    };
+
+    return CheckCollisionRecs(view, chunkRect);
+}
+
+void ChunkRenderer::update_pixels(const Chunk* chunk, PixelBuffer& pixels, const IntRect& rect) const
+{
+    for (int y = rect.min_y; y <= rect.max_y; y++)
+    {
+        for (int x = rect.min_x; x <= rect.max_x; x++)
+        {
+            const int index = x + y * c_width;
+            const Colour colour = chunk->is_empty(index) ? Colour::Blank : chunk->get_colour(index);
+
+            // skip anything that didnt actually change so the upload stays small
+            if (pixels.get_pixel(x, y) != colour)
+            {
+                pixels.set_pixel(x, y, colour);
+            }
+        }
+    }
+}
+
+void ChunkRenderer::upload_pixels(ChunkView& chunk_view)
+{
+    PixelBuffer& pixels = chunk_view.pixels;
+
+    if (!pixels.is_dirty()) return;
+
+    const IntRect& rect = pixels.get_dirty_rect();
+    const Rectangle upload_rect = {
+        static_cast<float>(rect.min_x),
+        static_cast<float>(rect.min_y),
+        static_cast<float>(rect.max_x - rect.min_x + 1),
+        static_cast<float>(rect.max_y - rect.min_y + 1)
+    };
+
+    // colour has the same layout as an rgba8 texture
+    UpdateTextureRec(chunk_view.texture, upload_rect, pixels.pack_dirty_pixels().data());
+
+    pixels.clear_dirty();
+}
+
+void ChunkRenderer::draw_chunk(const Chunk* chunk, const ChunkView& chunk_view, bool debug) const
+{
+    const Point chunk_position = chunk->get_position();
+
+    // set up texture source and position, cells are scaled up here
+    Rectangle sourceRec = {
+        0.0f,                        
+        0.0f,                        
+        static_cast<float>(c_width),
+        static_cast<float>(c_height)
+    };
+
+    Rectangle destRec = {
+        static_cast<float>(chunk_position.x),
+        static_cast<float>(chunk_position.y),
+        static_cast<float>(c_width * c_cell_size),
+        static_cast<float>(c_height * c_cell_size)
+    };
+
+    // draw texture
+    DrawTexturePro(chunk_view.texture, sourceRec, destRec, { 0, 0 }, 0.0f, WHITE);
+
+    if (debug)
+    {
+        const IntRect bounds = chunk->generate_bounds();
+
+        // draw chunk area
+        DrawRectangleLines(chunk_position.x, chunk_position.y, c_width * c_cell_size, c_height * c_cell_size, GREEN);
+
+        // draw the active rect of every awake tile over a shade of the whole tile
+        for (uint64_t tiles = chunk->get_awake_tiles(); tiles != 0; tiles &= tiles - 1)
+        {
+            const int tile = std::countr_zero(tiles);
+            const IntRect& tile_rect = chunk->get_tile_rect(tile);
+
+            DrawRectangle(
+                chunk_position.x + (tile % c_tiles_x) * c_tile_size * c_cell_size,
+                chunk_position.y + (tile / c_tiles_x) * c_tile_size * c_cell_size,
+                std::min(c_tile_size, c_width - (tile % c_tiles_x) * c_tile_size) * c_cell_size,
+                std::min(c_tile_size, c_height - (tile / c_tiles_x) * c_tile_size) * c_cell_size,
+                Fade(RED, 0.15f)
+            );
+
+            DrawRectangleLines(
+                chunk_position.x + tile_rect.min_x * c_cell_size,
+                chunk_position.y + tile_rect.min_y * c_cell_size,
+                (tile_rect.max_x - tile_rect.min_x + 1) * c_cell_size,
+                (tile_rect.max_y - tile_rect.min_y + 1) * c_cell_size,
+                RED
+            );
+        }
+
+        // draw drawing bounds
+        DrawRectangleLines(
+            chunk_position.x + bounds.min_x * c_cell_size,
+            chunk_position.y + bounds.min_y * c_cell_size,
+            (bounds.max_x - bounds.min_x + 1) * c_cell_size,
+            (bounds.max_y - bounds.min_y + 1) * c_cell_size,
+            WHITE
+        );
+
+        // draw pixel count
+        DrawText(TextFormat("%d", chunk->get_filled_cells()), chunk_position.x, chunk_position.y, 20, YELLOW);
+    }
+}
+
+void ChunkRenderer::draw_particles(const ParticleSystem& particles, const Rectangle& view) const
+{
+    // particles arent in any chunk texture, each one is a single rectangle on top
+    for (size_t i = 0; i < particles.size(); i++)
+    {
+        const Point cell = particles.get_position(i);
+        const Point position = { cell.x * c_cell_size, cell.y * c_cell_size };
+        const Rectangle particle_rect = {
+            static_cast<float>(position.x),
+            static_cast<float>(position.y),
+            static_cast<float>(c_cell_size),
+            static_cast<float>(c_cell_size)
+        };
+
+        if (!CheckCollisionRecs(view, particle_rect)) continue;
+
+        const Colour colour = particles.get_cell(i).colour;
+
+        DrawRectangle(position.x, position.y, c_cell_size, c_cell_size, { colour.r, colour.g, colour.b, colour.a });
+    }
+}
+
+void ChunkRenderer::release_hidden_views()
+{
+    for (auto it = m_views.begin(); it != m_views.end();)
+    {
+        if (!it->second.visible)
+        {
+            UnloadTexture(it->second.texture);
+            it = m_views.erase(it);
+        }
+        else 
+        {
+            it++;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <span>
+#include <unordered_map>
+
+#include <raylib.h>
+
+#include "rendering/pixel_buffer.hpp"
+#include "simulation/chunk.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "simulation/world_snapshot.hpp"
+#include "core/chunk_context.hpp"
+
+#include "utils/point.hpp"
+#include "utils/int_rect.hpp"
+
+class ChunkRenderer
+{
+public:
+    ChunkRenderer() = default;
+    ~ChunkRenderer();
+
+    ChunkRenderer(const ChunkRenderer&) = delete;
+    ChunkRenderer& operator=(const ChunkRenderer&) = delete;
+
+    void pre_draw(ChunkManager& manager, const Rectangle& view);
+    void draw(const ChunkManager& manager, const Rectangle& view, bool debug = false) const;
+
+    // the same from a snapshot, while the manager works on the next step
+    void pre_draw(WorldSnapshot& snapshot, const Rectangle& view);
+    void draw(const WorldSnapshot& snapshot, const Rectangle& view, bool debug = false) const;
+
+    size_t get_total_textures() const;
+
+private:
+    // one texture pixel per cell, scaled up when drawn
+    struct ChunkView
+    {
+        Texture2D texture;
+        PixelBuffer pixels = PixelBuffer(c_width, c_height);
+        bool visible = false;
+    };
+
+    void prepare_views(std::span<Chunk* const> chunks, const Rectangle& view);
+    void draw_chunks(std::span<Chunk* const> chunks, const ParticleSystem& particles, const Rectangle& view, bool debug) const;
+
+    bool is_chunk_in_view(const Chunk* chunk, const Rectangle& view) const;
+
+    void update_pixels(const Chunk* chunk, PixelBuffer& pixels, const IntRect& rect) const;
+    void upload_pixels(ChunkView& chunk_view);
+    void draw_chunk(const Chunk* chunk, const ChunkView& chunk_view, bool debug) const;
+    void draw_particles(const ParticleSystem& particles, const Rectangle& view) const;
+    void release_hidden_views();
+
+private:
+    static constexpr int c_width = ChunkContext::width;
+    static constexpr int c_height = ChunkContext::height;
+    static constexpr int c_cell_size = ChunkContext::cell_size;
+    static constexpr int c_tile_size = ChunkContext::tile_size;
+    static constexpr int c_tiles_x = (c_width + c_tile_size - 1) / c_tile_size;
+
+private:
+    // gpu resources only exist for chunks that are in view, keyed by chunk world position
+    std::unordered_map<Point, ChunkView> m_views;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <span>
+#include <vector>
+
+#include "utils/colour.hpp"
+#include "utils/int_rect.hpp"
+
+// cpu side copy of a texture, keeps track of what needs uploading
+class PixelBuffer
+{
+public:
+    PixelBuffer(int width, int height) : m_width(width), m_height(height), m_pixels(width * height, Colour::Blank)
+    {
+        clear_dirty();
+    }
+
+    int get_width() const { return m_width; }
+    int get_height() const { return m_height; }
+    const Colour* get_data() const { return m_pixels.data(); }
+
+    Colour get_pixel(int x, int y) const
+    {
+        assert(in_bounds(x, y) && "PixelBuffer::get_pixel out of bounds!");
+
+        return m_pixels[x + y * m_width];
+    }
+
+    void set_pixel(int x, int y, Colour colour)
+    {
+        assert(in_bounds(x, y) && "PixelBuffer::set_pixel out of bounds!");
+
+        m_pixels[x + y * m_width] = colour;
+
+        m_dirty_rect.min_x = std::min(m_dirty_rect.min_x, x);
+        m_dirty_rect.min_y = std::min(m_dirty_rect.min_y, y);
+        m_dirty_rect.max_x = std::max(m_dirty_rect.max_x, x);
+        m_dirty_rect.max_y = std::max(m_dirty_rect.max_y, y);
+    }
+
+    bool is_dirty() const
+    {
+        return m_dirty_rect.min_x <= m_dirty_rect.max_x && m_dirty_rect.min_y <= m_dirty_rect.max_y;
+    }
+
+    const IntRect& get_dirty_rect() const
+    {
+        return m_dirty_rect;
+    }
+
+    // copies the dirty rect into one tightly packed block, ready for a sub texture upload
+    std::span<const Colour> pack_dirty_pixels()
+    {
+        if (!is_dirty()) return {};
+
+        const int width = m_dirty_rect.max_x - m_dirty_rect.min_x + 1;
+        const int height = m_dirty_rect.max_y - m_dirty_rect.min_y + 1;
+
+        m_upload.resize(width * height);
+
+        for (int y = 0; y < height; y++)
+        {
+            const auto row = m_pixels.begin() + m_dirty_rect.min_x + (m_dirty_rect.min_y + y) * m_width;
+
+            std::copy_n(row, width, m_upload.begin() + y * width);
+        }
+
+        return m_upload;
+    }
+
+    void clear_dirty()
+    {
+        m_dirty_rect = { m_width, m_height, -1, -1 };
+    }
+
+private:
+    bool in_bounds(int x, int y) const
+    {
+        return x >= 0 && y >= 0 && x < m_width && y < m_height;
+    }
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    IntRect m_dirty_rect;
+
+    std::vector<Colour> m_pixels;
+    std::vector<Colour> m_upload;
+};
@@ -1,32 +1,64 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
 #include <boost/container/static_vector.hpp>
 
-#include <raylib.h>
-
 #include "core/cell.hpp"
 #include "core/chunk_context.hpp"
 
 #include "utils/point.hpp"
 #include "utils/int_rect.hpp"
+#include "utils/byte_stream.hpp"
+#include "utils/counter_random.hpp"
+#include "utils/trace.hpp"
+#include "simulation/move_resolver.hpp"
 
-class Chunk
+template<typename Context>
+class BasicChunk
 {
 public:
-    Chunk(Point position);
-    ~Chunk();
+    using ContextType = Context;
+
+    BasicChunk(Point position);
+
+    // puts the chunk back into the state of a new one, used when recycling chunks
+    void reset(Point position);
+    // copies the cells and rects of another chunk, neighbours are left alone
+    void copy_from(const BasicChunk& other);
 
     Point get_position() const;
     const IntRect& get_current_rect() const;
+    int get_filled_cells() const;
 
-    Cell& get_cell(int index);
-    Cell& get_cell(Point position);
+    Cell get_cell(int index) const;
+    Cell get_cell(Point position) const;
+
+    CellType get_type(int index) const;
+    CellType get_type(Point position) const;
+    Colour get_colour(int index) const;
+    Point get_velocity(int index) const;
+    void set_velocity(int index, Point velocity);
+    float get_life_time(int index) const;
+    void set_life_time(int index, float life_time);
 
     void set_cell(int index, const Cell& cell);
     void set_cell(Point position, const Cell& cell);
 
-    void move_cell(Point from_position, Point to_position, bool swap, Chunk* chunk);
+    void move_cell(Point from_position, Point to_position, bool swap, BasicChunk* chunk);
+    // queues the cells of row y to move distance cells straight down into empty cells, as a mask instead of a move each
+    // the cells take velocity with them, like a queued move they only land once the moves are applied
+    void drop_cells(int y, uint64_t cells, int distance, Point velocity);
+
+    BasicChunk* get_neighbour(int x, int y) const;
+    void set_neighbour(int x, int y, BasicChunk* chunk);
 
     bool in_bounds(int index) const;
     bool in_bounds(Point position) const;
@@ -36,44 +68,1205 @@ public:
     bool is_empty(int index) const;
     bool is_empty(Point position) const;
 
-    void apply_moved_cells();
+    bool in_halo_bounds(int x, int y) const;
+    CellType get_halo_type(int x, int y) const;
+    void refresh_halo();
+
+    // conflicting moves into the same cell are settled with random, so the result is the same in any update order
+    // returns how many of the queued moves were applied
+    int apply_moved_cells(const CounterRandom& random);
+    int get_queued_moves() const;
     void update_rect();
 
-    void pre_draw();
-    void draw(bool debug) const;
+    // the current rect is split into tiles, so active spots far apart dont keep the cells between them awake
+    // columns of row y inside the rect of an awake tile, what the workers update
+    uint64_t get_dirty_mask(int y) const;
+    // bit i is set if tile i has a current rect, tiles go row by row
+    uint64_t get_awake_tiles() const;
+    const IntRect& get_tile_rect(int tile) const;
+
+    IntRect generate_bounds() const;
+    bool is_row_empty(int y) const;
+    uint64_t get_row_mask(int y) const;
+    // the types of a row, the halo columns are readable before and after it
+    const CellType* get_row_types(int y) const;
+    bool is_column_empty(int x) const;
+    // false while every cell still has its default velocity
+    bool has_velocities() const;
+    // cells of row y with a velocity other than zero, bit x for column x
+    uint64_t get_moving_mask(int y) const;
+    // false while every cell still has its default life time
+    bool has_life_times() const;
+    const IntRect& get_changed_rect() const;
+    void clear_changed_rect();
+    // grows the changed rect to cover rect as well
+    void merge_changed_rect(const IntRect& rect);
+
+    // cells and rects as a compact binary blob, empty runs cost a few bytes
+    void serialize(ByteWriter& writer) const;
+    bool deserialize(ByteReader& reader);
 
     bool should_remove() const;
+    int count_empty_step();
+
+    // nothing moved last step and nothing woke the chunk since
+    bool is_asleep() const;
+    int get_asleep_steps() const;
 
 private:
     int get_index(Point position) const;
+    int get_halo_index(int x, int y) const;
+    int get_type_index(int index) const;
+    int get_neighbour_index(int x, int y) const;
+    int get_neighbour_slot(const BasicChunk* chunk) const;
+
+    void rebuild_occupancy();
+
+    // moves the dropped cells that no queued move touches straight to the grid, the others join the queued moves
+    int apply_drops();
+    void move_cells_down(int y, uint64_t cells, int distance);
 
     void set_next_rect(int index);
-    void generate_bounds();
-    void reset_rect(IntRect& rect);
+    void set_next_rect(const IntRect& rect);
+    void reset_rect(IntRect& rect) const;
+    // ors the columns of every awake tile into the rows it covers
+    void add_dirty_masks();
+    static void grow_rect(IntRect& rect, const IntRect& other);
+
+    template<typename T, size_t N, typename DefaultOf>
+    static void set_attribute(std::unique_ptr<std::array<T, N>>& attributes, int index, T value, DefaultOf default_of)
+    {
+        if (attributes == nullptr)
+        {
+            // nothing to store until a cell needs it
+            if (value == default_of(index)) return;
+
+            // filled before it is stored, anything that sees the array sees the defaults
+            auto filled = std::make_unique<std::array<T, N>>();
+
+            for (int i = 0; i < static_cast<int>(N); i++)
+            {
+                (*filled)[i] = default_of(i);
+            }
+
+            attributes = std::move(filled);
+        }
+
+        (*attributes)[index] = value;
+    }
 
 private:
+    enum AttributeFlags : uint8_t
+    {
+        HasColours    = 1 << 0,
+        HasVelocities = 1 << 1,
+        HasLifeTimes  = 1 << 2,
+    };
+
     struct CellChange
     {
         int src_index = 0;
         int dst_index = 0;
         bool swap = false;
-        Chunk* chunk = nullptr;
+        BasicChunk* chunk = nullptr;
     };
 
-    static constexpr int c_width = ChunkContext::width;
-    static constexpr int c_height = ChunkContext::height;
-    static constexpr int c_cell_size = ChunkContext::cell_size;
+    static constexpr int c_width = Context::width;
+    static constexpr int c_height = Context::height;
+    static constexpr int c_halo = Context::halo;
+    static constexpr int c_stride = c_width + c_halo * 2;
+
+    static constexpr int c_tile_size = Context::tile_size;
+    static constexpr int c_tiles_x = (c_width + c_tile_size - 1) / c_tile_size;
+    static constexpr int c_tiles_y = (c_height + c_tile_size - 1) / c_tile_size;
+    static constexpr int c_tiles = c_tiles_x * c_tiles_y;
+
+    // as far as a cell can move in a step
+    static constexpr int c_max_drop = 8;
+
+    static_assert(c_width <= 64, "a row has to fit into a 64 bit mask");
+    static_assert(c_tiles <= 64, "the awake tiles have to fit into a 64 bit mask");
+
+    using TileRects = std::array<IntRect, c_tiles>;
 
 private:
+    // guards the changes and rects that neighbouring chunks write to in parallel updates
+    std::mutex m_mutex;
+
     Point m_position;
     int m_filled_cells = 0;
-    bool m_drawn = false;
+    int m_empty_steps = 0;
+    int m_asleep_steps = 0;
 
-    IntRect m_final_rect;
+    // filled cells as a bit per cell for each row and a count per column, kept alongside m_filled_cells
+    std::array<uint64_t, c_height> m_row_masks = {};
+    std::array<uint16_t, c_width> m_column_counts = {};
+
+    // surrounding chunks, kept up to date by the chunk manager
+    std::array<BasicChunk*, 8> m_neighbours = {};
+
+    IntRect m_changed_rect; // cells that need to be redrawn
     IntRect m_intermediate_rect;
     IntRect m_dirty_rect;
 
+    // the rects above per tile, a tile's rect is only valid while its bit is set
+    uint64_t m_intermediate_tiles = 0;
+    uint64_t m_dirty_tiles = 0;
+    TileRects m_intermediate_tile_rects;
+    TileRects m_dirty_tile_rects;
+    std::array<uint64_t, c_height> m_dirty_masks = {};
+
     boost::container::static_vector<CellChange, c_width * c_height> m_changes;
-    std::array<Cell, c_width * c_height> m_grid;
-    RenderTexture2D m_render_texture;
-};
\ No newline at end of file
+    std::array<uint64_t, c_height> m_claimed_masks = {};
+    // cells dropped distance + 1 rows, by the row they start in
+    std::array<std::array<uint64_t, c_height>, c_max_drop> m_drop_masks = {};
+    int m_queued_drops = 0;
+
+    // cells are split by attribute, side arrays only exist once a cell needs a non default value
+    // types are padded with a halo of the neighbours cells so rules can read around them directly
+    std::array<CellType, c_stride * (c_height + c_halo * 2)> m_types;
+    std::unique_ptr<std::array<Colour, c_width * c_height>> m_colours;
+    std::unique_ptr<std::array<Point, c_width * c_height>> m_velocities;
+    std::unique_ptr<std::array<float, c_width * c_height>> m_life_times;
+};
+
+template<typename Context>
+BasicChunk<Context>::BasicChunk(Point position)
+{
+    reset(position);
+}
+
+template<typename Context>
+void BasicChunk<Context>::reset(Point position)
+{
+    m_position = position;
+    m_filled_cells = 0;
+    m_empty_steps = 0;
+    m_asleep_steps = 0;
+
+    m_types.fill(CellType::Empty);
+    m_row_masks.fill(0);
+    m_column_counts.fill(0);
+    m_neighbours.fill(nullptr);
+    m_changes.clear();
+    m_claimed_masks.fill(0);
+    m_drop_masks = {};
+    m_queued_drops = 0;
+
+    // keep side arrays that were already allocated, they will likely be needed again
+    if (m_colours != nullptr)    m_colours->fill(Cell::Empty.colour);
+    if (m_velocities != nullptr) m_velocities->fill(Cell::Empty.velocity);
+    if (m_life_times != nullptr) m_life_times->fill(Cell::Empty.life_time);
+
+    // a new chunk has never been drawn
+    m_changed_rect = { 0, 0, c_width - 1, c_height - 1 };
+
+    reset_rect(m_intermediate_rect);
+    reset_rect(m_dirty_rect);
+
+    m_intermediate_tiles = 0;
+    m_dirty_tiles = 0;
+    m_dirty_masks.fill(0);
+}
+
+template<typename Context>
+void BasicChunk<Context>::copy_from(const BasicChunk& other)
+{
+    m_position = other.m_position;
+    m_filled_cells = other.m_filled_cells;
+    m_empty_steps = other.m_empty_steps;
+    m_asleep_steps = other.m_asleep_steps;
+
+    m_types = other.m_types;
+    m_row_masks = other.m_row_masks;
+    m_column_counts = other.m_column_counts;
+
+    m_changed_rect = other.m_changed_rect;
+    m_intermediate_rect = other.m_intermediate_rect;
+    m_dirty_rect = other.m_dirty_rect;
+    m_intermediate_tiles = other.m_intermediate_tiles;
+    m_dirty_tiles = other.m_dirty_tiles;
+    m_intermediate_tile_rects = other.m_intermediate_tile_rects;
+    m_dirty_tile_rects = other.m_dirty_tile_rects;
+    m_dirty_masks = other.m_dirty_masks;
+
+    // side arrays follow the other chunk, a missing one means every cell has its default
+    const auto copy_attribute = [](auto& to, const auto& from)
+    {
+        if (from == nullptr)
+        {
+            to.reset();
+        }
+        else if (to == nullptr)
+        {
+            to = std::make_unique<typename std::decay_t<decltype(from)>::element_type>(*from);
+        }
+        else 
+        {
+            *to = *from;
+        }
+    };
+
+    copy_attribute(m_colours, other.m_colours);
+    copy_attribute(m_velocities, other.m_velocities);
+    copy_attribute(m_life_times, other.m_life_times);
+}
+
+template<typename Context>
+Point BasicChunk<Context>::get_position() const
+{
+    return m_position;
+}
+
+template<typename Context>
+const IntRect& BasicChunk<Context>::get_current_rect() const
+{
+    return m_dirty_rect;
+}
+
+template<typename Context>
+int BasicChunk<Context>::get_filled_cells() const
+{
+    return m_filled_cells;
+}
+
+template<typename Context>
+Cell BasicChunk<Context>::get_cell(int index) const
+{
+    assert(in_bounds(index) && "Chunk::get_cell out of bounds!");
+
+    // put the cell back together from its attributes
+    Cell cell = Cell::get_default(m_types[get_type_index(index)]);
+
+    if (m_colours != nullptr)    cell.colour = (*m_colours)[index];
+    if (m_velocities != nullptr) cell.velocity = (*m_velocities)[index];
+    if (m_life_times != nullptr) cell.life_time = (*m_life_times)[index];
+
+    return cell;
+}
+
+template<typename Context>
+Cell BasicChunk<Context>::get_cell(Point position) const
+{
+    assert(in_bounds(position) && "Chunk::get_cell out of bounds!");
+
+    return get_cell(get_index(position));
+}
+
+template<typename Context>
+CellType BasicChunk<Context>::get_type(int index) const
+{
+    assert(in_bounds(index) && "Chunk::get_type out of bounds!");
+
+    return m_types[get_type_index(index)];
+}
+
+template<typename Context>
+CellType BasicChunk<Context>::get_type(Point position) const
+{
+    assert(in_bounds(position) && "Chunk::get_type out of bounds!");
+
+    return get_type(get_index(position));
+}
+
+template<typename Context>
+Colour BasicChunk<Context>::get_colour(int index) const
+{
+    assert(in_bounds(index) && "Chunk::get_colour out of bounds!");
+
+    if (m_colours != nullptr) return (*m_colours)[index];
+
+    return Cell::get_default(m_types[get_type_index(index)]).colour;
+}
+
+template<typename Context>
+Point BasicChunk<Context>::get_velocity(int index) const
+{
+    assert(in_bounds(index) && "Chunk::get_velocity out of bounds!");
+
+    if (m_velocities != nullptr) return (*m_velocities)[index];
+
+    return Cell::get_default(m_types[get_type_index(index)]).velocity;
+}
+
+template<typename Context>
+void BasicChunk<Context>::set_velocity(int index, Point velocity)
+{
+    assert(in_bounds(index) && "Chunk::set_velocity out of bounds!");
+
+    set_attribute(m_velocities, index, velocity, [this](int i) { return Cell::get_default(m_types[get_type_index(i)]).velocity; });
+}
+
+template<typename Context>
+float BasicChunk<Context>::get_life_time(int index) const
+{
+    assert(in_bounds(index) && "Chunk::get_life_time out of bounds!");
+
+    if (m_life_times != nullptr) return (*m_life_times)[index];
+
+    return Cell::get_default(m_types[get_type_index(index)]).life_time;
+}
+
+template<typename Context>
+void BasicChunk<Context>::set_life_time(int index, float life_time)
+{
+    assert(in_bounds(index) && "Chunk::set_life_time out of bounds!");
+
+    set_attribute(m_life_times, index, life_time, [this](int i) { return Cell::get_default(m_types[get_type_index(i)]).life_time; });
+}
+
+template<typename Context>
+void BasicChunk<Context>::set_cell(int index, const Cell& cell) 
+{
+    assert(in_bounds(index) && "Chunk::set_cell out of bounds!");
+
+    // allows to overwrite the grid
+    CellType& dest = m_types[get_type_index(index)];
+
+    const int x = index % c_width;
+    const int y = index / c_width;
+
+    // checks if im filling or removing a cell
+    if (dest == CellType::Empty && cell.type != CellType::Empty)
+    {
+        m_filled_cells++;
+        m_row_masks[y] |= uint64_t(1) << x;
+        m_column_counts[x]++;
+    }
+    else if (dest != CellType::Empty && cell.type == CellType::Empty)
+    {
+        m_filled_cells--;
+        m_row_masks[y] &= ~(uint64_t(1) << x);
+        m_column_counts[x]--;
+    }
+
+    // set and flag grid
+    dest = cell.type;
+    set_attribute(m_colours, index, cell.colour, [this](int i) { return Cell::get_default(m_types[get_type_index(i)]).colour; });
+    set_attribute(m_velocities, index, cell.velocity, [this](int i) { return Cell::get_default(m_types[get_type_index(i)]).velocity; });
+    set_attribute(m_life_times, index, cell.life_time, [this](int i) { return Cell::get_default(m_types[get_type_index(i)]).life_time; });
+
+    // flag cell for drawing
+    m_changed_rect.min_x = std::min(m_changed_rect.min_x, x);
+    m_changed_rect.min_y = std::min(m_changed_rect.min_y, y);
+    m_changed_rect.max_x = std::max(m_changed_rect.max_x, x);
+    m_changed_rect.max_y = std::max(m_changed_rect.max_y, y);
+    
+    // wake up chunk to apply changes
+    set_next_rect(index);
+}
+
+template<typename Context>
+void BasicChunk<Context>::set_cell(Point position, const Cell& cell) 
+{
+    set_cell(get_index(position), cell);
+}
+
+template<typename Context>
+void BasicChunk<Context>::move_cell(Point from_position, Point to_position, bool swap, BasicChunk* chunk)
+{
+    assert(chunk != nullptr && "Chunk::move_cell chunk is nullptr!");
+
+    std::lock_guard lock(m_mutex);
+
+    // keep track of the changes
+    m_changes.emplace_back(
+        get_index(from_position),
+        get_index(to_position),
+        swap,
+        chunk
+    );
+
+    m_claimed_masks[to_position.y] |= uint64_t(1) << to_position.x;
+}
+
+template<typename Context>
+void BasicChunk<Context>::drop_cells(int y, uint64_t cells, int distance, Point velocity)
+{
+    if (cells == 0) return;
+
+    assert(distance >= 1 && distance <= c_max_drop && y >= 0 && y + distance < c_height && "Chunk::drop_cells out of bounds!");
+    assert((m_row_masks[y] & cells) == cells && "Chunk::drop_cells needs filled cells!");
+    assert(!has_life_times() && "Chunk::drop_cells cant move life times!");
+
+    // the velocity goes on before the move, like for a queued one, a drop that loses a conflict keeps it where it is
+    for (uint64_t dropped = cells; dropped != 0; dropped &= dropped - 1)
+    {
+        set_velocity(std::countr_zero(dropped) + y * c_width, velocity);
+    }
+
+    m_drop_masks[distance - 1][y] |= cells;
+    m_queued_drops += std::popcount(cells);
+}
+
+template<typename Context>
+BasicChunk<Context>* BasicChunk<Context>::get_neighbour(int x, int y) const
+{
+    return m_neighbours[get_neighbour_index(x, y)];
+}
+
+template<typename Context>
+void BasicChunk<Context>::set_neighbour(int x, int y, BasicChunk* chunk)
+{
+    m_neighbours[get_neighbour_index(x, y)] = chunk;
+}
+
+template<typename Context>
+bool BasicChunk<Context>::in_bounds(int index) const
+{
+    return index >= 0 && index < c_width * c_height;
+}
+
+template<typename Context>
+bool BasicChunk<Context>::in_bounds(Point position) const
+{
+    return position.x >= 0 && position.y >= 0 && position.x < c_width && position.y < c_height;
+}
+
+template<typename Context>
+void BasicChunk<Context>::wake_up(Point position)
+{
+    assert(in_bounds(position) && "Chunk::wake_up out of bounds!");
+
+    std::lock_guard lock(m_mutex);
+
+    // wake up change by modifying to iteration bounds
+    set_next_rect(get_index(position));
+}
+
+template<typename Context>
+bool BasicChunk<Context>::is_empty(int index) const
+{
+    assert(in_bounds(index) && "Chunk::is_empty out of bounds!");
+
+    return m_types[get_type_index(index)] == CellType::Empty;
+}
+
+template<typename Context>
+bool BasicChunk<Context>::is_empty(Point position) const
+{
+    return is_empty(get_index(position));
+}
+
+template<typename Context>
+bool BasicChunk<Context>::in_halo_bounds(int x, int y) const
+{
+    return x >= -c_halo && y >= -c_halo && x < c_width + c_halo && y < c_height + c_halo;
+}
+
+template<typename Context>
+CellType BasicChunk<Context>::get_halo_type(int x, int y) const
+{
+    assert(in_halo_bounds(x, y) && "Chunk::get_halo_type out of bounds!");
+
+    return m_types[get_halo_index(x, y)];
+}
+
+template<typename Context>
+void BasicChunk<Context>::refresh_halo()
+{
+    // copy the border of every neighbour into the halo, missing ones are air
+    for (int offset_y = -1; offset_y <= 1; offset_y++)
+    {
+        for (int offset_x = -1; offset_x <= 1; offset_x++)
+        {
+            if (offset_x == 0 && offset_y == 0) continue;
+
+            // part of the halo that this neighbour covers
+            const int min_x = offset_x < 0 ? -c_halo : (offset_x > 0 ? c_width : 0);
+            const int min_y = offset_y < 0 ? -c_halo : (offset_y > 0 ? c_height : 0);
+            const int max_x = offset_x < 0 ? 0 : (offset_x > 0 ? c_width + c_halo : c_width);
+            const int max_y = offset_y < 0 ? 0 : (offset_y > 0 ? c_height + c_halo : c_height);
+            const int length = max_x - min_x;
+
+            const BasicChunk* neighbour = get_neighbour(offset_x, offset_y);
+
+            for (int y = min_y; y < max_y; y++)
+            {
+                CellType* dest = &m_types[get_halo_index(min_x, y)];
+
+                if (neighbour == nullptr)
+                {
+                    std::fill_n(dest, length, CellType::Empty);
+                }
+                else 
+                {
+                    const int src_index = get_halo_index(min_x - offset_x * c_width, y - offset_y * c_height);
+
+                    std::copy_n(&neighbour->m_types[src_index], length, dest);
+                }
+            }
+        }
+    }
+}
+
+template<typename Context>
+int BasicChunk<Context>::apply_moved_cells(const CounterRandom& random)
+{
+    if (m_changes.empty() && m_queued_drops == 0) return 0;
+
+    TRACE_SCOPE_CHUNK("apply_moved_cells", Point(m_position.x / (c_width * Context::cell_size), m_position.y / (c_height * Context::cell_size)));
+
+    int applied = m_queued_drops != 0 ? apply_drops() : 0;
+
+    // scratch space is shared between all chunks applied on a thread
+    thread_local MoveResolver<c_width * c_height> resolver;
+
+    // a random number for the source cell, then where it came from to break ties
+    const auto priority = [&](const CellChange& change)
+    {
+        const int source = change.chunk == this ? 8 : get_neighbour_slot(change.chunk);
+
+        return 
+            static_cast<uint64_t>(random.get(change.chunk->m_position, change.src_index)) << 32 |
+            static_cast<uint64_t>(source) << 16 | 
+            static_cast<uint64_t>(change.src_index);
+    };
+
+    // handle destination confliction
+    resolver.resolve(std::span<const CellChange>(m_changes.data(), m_changes.size()), priority, [&](const CellChange& change)
+    {
+        applied++;
+
+        // move cells from the source to destination
+        Cell src_cell = change.swap ? get_cell(change.dst_index) : Cell();
+
+        if (change.chunk == this)
+        {
+            set_cell(change.dst_index, get_cell(change.src_index));
+            set_cell(change.src_index, src_cell);
+        }
+        else 
+        {
+            Cell moved_cell;
+
+            // neighbours can be read and emptied by two chunks of the same phase
+            {
+                std::lock_guard lock(change.chunk->m_mutex);
+                moved_cell = change.chunk->get_cell(change.src_index);
+                change.chunk->set_cell(change.src_index, src_cell);
+            }
+
+            set_cell(change.dst_index, moved_cell);
+        }
+    });
+
+    // clear for the next changes
+    m_changes.clear();
+    m_claimed_masks.fill(0);
+
+    return applied;
+}
+
+template<typename Context>
+int BasicChunk<Context>::get_queued_moves() const
+{
+    return static_cast<int>(m_changes.size()) + m_queued_drops;
+}
+
+template<typename Context>
+int BasicChunk<Context>::apply_drops()
+{
+    // cells the queued moves of this chunk start from, the moves from neighbours only touch this chunk where they land
+    std::array<uint64_t, c_height> sources = {};
+
+    for (const CellChange& change : m_changes)
+    {
+        if (change.chunk == this) sources[change.src_index / c_width] |= uint64_t(1) << (change.src_index % c_width);
+    }
+
+    int applied = 0;
+
+    for (int distance = 1; distance <= c_max_drop; distance++)
+    {
+        auto& drop_masks = m_drop_masks[distance - 1];
+
+        for (int y = 0; y + distance < c_height; y++)
+        {
+            const uint64_t cells = drop_masks[y];
+
+            if (cells == 0) continue;
+
+            drop_masks[y] = 0;
+
+            // a drop touching no queued move gives the same grid whenever it is applied, the rest go through the resolver
+            const uint64_t touched = cells & (
+                m_claimed_masks[y] | m_claimed_masks[y + distance] | 
+                sources[y] | sources[y + distance]
+            );
+
+            for (uint64_t queued = touched; queued != 0; queued &= queued - 1)
+            {
+                const int src_index = std::countr_zero(queued) + y * c_width;
+
+                m_changes.emplace_back(src_index, src_index + distance * c_width, false, this);
+            }
+
+            move_cells_down(y, cells & ~touched, distance);
+            applied += std::popcount(cells & ~touched);
+        }
+    }
+
+    m_queued_drops = 0;
+
+    return applied;
+}
+
+template<typename Context>
+void BasicChunk<Context>::move_cells_down(int y, uint64_t cells, int distance)
+{
+    assert((m_row_masks[y] & cells) == cells && (m_row_masks[y + distance] & cells) == 0 && "Chunk::move_cells_down needs filled cells over empty ones!");
+
+    if (cells == 0) return;
+
+    CellType* types = &m_types[get_halo_index(0, y)];
+    CellType* types_below = &m_types[get_halo_index(0, y + distance)];
+
+    // branch free over the whole row so the compiler can vectorise it
+    for (int x = 0; x < c_width; x++)
+    {
+        const bool drop = (cells >> x) & 1;
+
+        types_below[x] = drop ? types[x] : types_below[x];
+        types[x] = drop ? CellType::Empty : types[x];
+    }
+
+    if (m_colours != nullptr)
+    {
+        Colour* colours = &(*m_colours)[y * c_width];
+        Colour* colours_below = &(*m_colours)[(y + distance) * c_width];
+
+        for (int x = 0; x < c_width; x++)
+        {
+            const bool drop = (cells >> x) & 1;
+
+            colours_below[x] = drop ? colours[x] : colours_below[x];
+            colours[x] = drop ? Cell::Empty.colour : colours[x];
+        }
+    }
+
+    // the velocity moves with the cell, the cells left behind have the empty one
+    for (uint64_t dropped = cells; dropped != 0; dropped &= dropped - 1)
+    {
+        const int index = std::countr_zero(dropped) + y * c_width;
+
+        set_velocity(index + distance * c_width, get_velocity(index));
+        set_velocity(index, Cell::Empty.velocity);
+    }
+
+    // the cells only changed rows, the column counts stay the same
+    m_row_masks[y] &= ~cells;
+    m_row_masks[y + distance] |= cells;
+
+    const int min_x = std::countr_zero(cells);
+    const int max_x = c_width - 1 - std::countl_zero(cells << (64 - c_width));
+
+    grow_rect(m_changed_rect, { min_x, y, max_x, y + distance });
+
+    // wake up what set_cell would around both cells of every move, a run of cells at a time
+    for (uint64_t runs = cells; runs != 0;)
+    {
+        const int first = std::countr_zero(runs);
+        const int last = first + std::countr_one(runs >> first) - 1;
+
+        set_next_rect({
+            std::max(first - 2, 0),
+            std::max(y - 2, 0),
+            std::min(last + 2, c_width - 1),
+            std::min(y + distance + 2, c_height - 1)
+        });
+
+        runs &= last + 1 < 64 ? ~uint64_t(0) << (last + 1) : 0;
+    }
+}
+
+template<typename Context>
+void BasicChunk<Context>::update_rect()
+{
+    // the masks only have columns while tiles are awake
+    if (m_dirty_tiles != 0) m_dirty_masks.fill(0);
+
+    m_dirty_rect = m_intermediate_rect;
+    m_dirty_tiles = m_intermediate_tiles;
+    m_dirty_tile_rects = m_intermediate_tile_rects;
+
+    reset_rect(m_intermediate_rect);
+    m_intermediate_tiles = 0;
+
+    add_dirty_masks();
+
+    // how many steps in a row nothing happened in the chunk
+    m_asleep_steps = m_dirty_rect.min_x > m_dirty_rect.max_x ? m_asleep_steps + 1 : 0;
+}
+
+template<typename Context>
+uint64_t BasicChunk<Context>::get_dirty_mask(int y) const
+{
+    assert(y >= 0 && y < c_height && "Chunk::get_dirty_mask out of bounds!");
+
+    return m_dirty_masks[y];
+}
+
+template<typename Context>
+uint64_t BasicChunk<Context>::get_awake_tiles() const
+{
+    return m_dirty_tiles;
+}
+
+template<typename Context>
+const IntRect& BasicChunk<Context>::get_tile_rect(int tile) const
+{
+    assert(tile >= 0 && tile < c_tiles && "Chunk::get_tile_rect out of bounds!");
+
+    return m_dirty_tile_rects[tile];
+}
+
+template<typename Context>
+IntRect BasicChunk<Context>::generate_bounds() const
+{
+    // generate a rect based on all the valid tiles
+    IntRect bounds;
+    reset_rect(bounds);
+
+    if (m_filled_cells == 0) return bounds;
+
+    // the first and last filled row and column, theres at least one filled cell
+    for (bounds.min_y = 0; m_row_masks[bounds.min_y] == 0; bounds.min_y++) { }
+    for (bounds.max_y = c_height - 1; m_row_masks[bounds.max_y] == 0; bounds.max_y--) { }
+    for (bounds.min_x = 0; m_column_counts[bounds.min_x] == 0; bounds.min_x++) { }
+    for (bounds.max_x = c_width - 1; m_column_counts[bounds.max_x] == 0; bounds.max_x--) { }
+
+    return bounds;
+}
+
+template<typename Context>
+bool BasicChunk<Context>::is_row_empty(int y) const
+{
+    assert(y >= 0 && y < c_height && "Chunk::is_row_empty out of bounds!");
+
+    return m_row_masks[y] == 0;
+}
+
+template<typename Context>
+uint64_t BasicChunk<Context>::get_row_mask(int y) const
+{
+    assert(y >= 0 && y < c_height && "Chunk::get_row_mask out of bounds!");
+
+    return m_row_masks[y];
+}
+
+template<typename Context>
+const CellType* BasicChunk<Context>::get_row_types(int y) const
+{
+    assert(y >= 0 && y < c_height && "Chunk::get_row_types out of bounds!");
+
+    return &m_types[get_halo_index(0, y)];
+}
+
+template<typename Context>
+bool BasicChunk<Context>::has_velocities() const
+{
+    return m_velocities != nullptr;
+}
+
+template<typename Context>
+uint64_t BasicChunk<Context>::get_moving_mask(int y) const
+{
+    assert(y >= 0 && y < c_height && "Chunk::get_moving_mask out of bounds!");
+
+    if (m_velocities == nullptr) return 0;
+
+    const Point* velocities = &(*m_velocities)[y * c_width];
+    uint64_t mask = 0;
+
+    // branch free, most rows are scanned to find none
+    for (int x = 0; x < c_width; x++)
+    {
+        mask |= uint64_t(velocities[x] != Point::zero()) << x;
+    }
+
+    return mask;
+}
+
+template<typename Context>
+bool BasicChunk<Context>::has_life_times() const
+{
+    return m_life_times != nullptr;
+}
+
+template<typename Context>
+bool BasicChunk<Context>::is_column_empty(int x) const
+{
+    assert(x >= 0 && x < c_width && "Chunk::is_column_empty out of bounds!");
+
+    return m_column_counts[x] == 0;
+}
+
+template<typename Context>
+const IntRect& BasicChunk<Context>::get_changed_rect() const
+{
+    return m_changed_rect;
+}
+
+template<typename Context>
+void BasicChunk<Context>::clear_changed_rect()
+{
+    reset_rect(m_changed_rect);
+}
+
+template<typename Context>
+void BasicChunk<Context>::merge_changed_rect(const IntRect& rect)
+{
+    grow_rect(m_changed_rect, rect);
+}
+
+template<typename Context>
+void BasicChunk<Context>::serialize(ByteWriter& writer) const
+{
+    // only the tiles that are awake, the whole chunk rects are rebuilt from them
+    const std::pair<uint64_t, const TileRects*> tile_states[] = {
+        { m_dirty_tiles, &m_dirty_tile_rects },
+        { m_intermediate_tiles, &m_intermediate_tile_rects }
+    };
+
+    for (const auto& [tiles, rects] : tile_states)
+    {
+        writer.write(tiles);
+
+        for (uint64_t awake = tiles; awake != 0; awake &= awake - 1)
+        {
+            const IntRect& rect = (*rects)[std::countr_zero(awake)];
+
+            writer.write<int16_t>(rect.min_x);
+            writer.write<int16_t>(rect.min_y);
+            writer.write<int16_t>(rect.max_x);
+            writer.write<int16_t>(rect.max_y);
+        }
+    }
+
+    uint8_t flags = 0;
+
+    if (m_colours != nullptr)    flags |= HasColours;
+    if (m_velocities != nullptr) flags |= HasVelocities;
+    if (m_life_times != nullptr) flags |= HasLifeTimes;
+
+    writer.write(flags);
+
+    // run length encode the types, most chunks are long runs of air
+    uint16_t run_count = 0;
+
+    for (int i = 0; i < c_width * c_height; i++)
+    {
+        if (i == 0 || get_type(i) != get_type(i - 1)) run_count++;
+    }
+
+    writer.write(run_count);
+
+    for (int start = 0; start < c_width * c_height;)
+    {
+        const CellType type = get_type(start);
+        int end = start + 1;
+
+        while (end < c_width * c_height && get_type(end) == type) end++;
+
+        writer.write(type);
+        writer.write<uint16_t>(end - start);
+
+        start = end;
+    }
+
+    // attributes are only kept for filled cells
+    for (int y = 0; y < c_height; y++)
+    {
+        for (uint64_t filled = m_row_masks[y]; filled != 0; filled &= filled - 1)
+        {
+            const int index = std::countr_zero(filled) + y * c_width;
+
+            if (flags & HasColours)    writer.write((*m_colours)[index]);
+            if (flags & HasVelocities) writer.write((*m_velocities)[index]);
+            if (flags & HasLifeTimes)  writer.write((*m_life_times)[index]);
+        }
+    }
+}
+
+template<typename Context>
+bool BasicChunk<Context>::deserialize(ByteReader& reader)
+{
+    uint64_t tile_masks[2] = {};
+    TileRects tile_rects[2];
+    IntRect rects[2];
+
+    for (int state = 0; state < 2; state++)
+    {
+        reset_rect(rects[state]);
+
+        if (!reader.read(tile_masks[state])) return false;
+        if (c_tiles < 64 && (tile_masks[state] >> c_tiles) != 0) return false;
+
+        for (uint64_t awake = tile_masks[state]; awake != 0; awake &= awake - 1)
+        {
+            const int tile = std::countr_zero(awake);
+            const int tile_x = tile % c_tiles_x * c_tile_size;
+            const int tile_y = tile / c_tiles_x * c_tile_size;
+
+            int16_t values[4];
+
+            if (!reader.read(values)) return false;
+
+            const IntRect rect = { values[0], values[1], values[2], values[3] };
+
+            // the masks are built from these, anything outside the tile is broken
+            if (rect.min_x < tile_x || rect.min_y < tile_y || rect.min_x > rect.max_x || rect.min_y > rect.max_y ||
+                rect.max_x >= std::min(tile_x + c_tile_size, c_width) || rect.max_y >= std::min(tile_y + c_tile_size, c_height))
+            {
+                return false;
+            }
+
+            tile_rects[state][tile] = rect;
+            grow_rect(rects[state], rect);
+        }
+    }
+
+    uint8_t flags = 0;
+    uint16_t run_count = 0;
+
+    if (!reader.read(flags) || !reader.read(run_count)) return false;
+
+    // types go straight into the grid
+    int index = 0;
+
+    for (int run = 0; run < run_count; run++)
+    {
+        CellType type = CellType::Empty;
+        uint16_t length = 0;
+
+        if (!reader.read(type) || !reader.read(length)) return false;
+        if (index + length > c_width * c_height) return false;
+
+        for (int end = index + length; index < end; index++)
+        {
+            m_types[get_type_index(index)] = type;
+        }
+    }
+
+    if (index != c_width * c_height) return false;
+
+    rebuild_occupancy();
+
+    // start from the defaults then fill in what was saved for each filled cell
+    if ((flags & HasColours) && m_colours == nullptr)       m_colours = std::make_unique<typename decltype(m_colours)::element_type>();
+    if ((flags & HasVelocities) && m_velocities == nullptr) m_velocities = std::make_unique<typename decltype(m_velocities)::element_type>();
+    if ((flags & HasLifeTimes) && m_life_times == nullptr)  m_life_times = std::make_unique<typename decltype(m_life_times)::element_type>();
+
+    for (int i = 0; i < c_width * c_height; i++)
+    {
+        const Cell& default_cell = Cell::get_default(get_type(i));
+
+        if (m_colours != nullptr)    (*m_colours)[i] = default_cell.colour;
+        if (m_velocities != nullptr) (*m_velocities)[i] = default_cell.velocity;
+        if (m_life_times != nullptr) (*m_life_times)[i] = default_cell.life_time;
+    }
+
+    for (int y = 0; y < c_height; y++)
+    {
+        for (uint64_t filled = m_row_masks[y]; filled != 0; filled &= filled - 1)
+        {
+            const int cell_index = std::countr_zero(filled) + y * c_width;
+
+            if ((flags & HasColours) && !reader.read((*m_colours)[cell_index])) return false;
+            if ((flags & HasVelocities) && !reader.read((*m_velocities)[cell_index])) return false;
+            if ((flags & HasLifeTimes) && !reader.read((*m_life_times)[cell_index])) return false;
+        }
+    }
+
+    m_dirty_rect = rects[0];
+    m_intermediate_rect = rects[1];
+    m_dirty_tiles = tile_masks[0];
+    m_intermediate_tiles = tile_masks[1];
+    m_dirty_tile_rects = tile_rects[0];
+    m_intermediate_tile_rects = tile_rects[1];
+
+    m_dirty_masks.fill(0);
+    add_dirty_masks();
+
+    // everything needs drawing again
+    m_changed_rect = { 0, 0, c_width - 1, c_height - 1 };
+
+    return true;
+}
+
+template<typename Context>
+bool BasicChunk<Context>::should_remove() const
+{
+    return m_filled_cells == 0;
+}
+
+template<typename Context>
+int BasicChunk<Context>::count_empty_step()
+{
+    // how many steps in a row the chunk has been empty
+    m_empty_steps = should_remove() ? m_empty_steps + 1 : 0;
+
+    return m_empty_steps;
+}
+
+template<typename Context>
+bool BasicChunk<Context>::is_asleep() const
+{
+    return 
+        m_dirty_rect.min_x > m_dirty_rect.max_x && 
+        m_intermediate_rect.min_x > m_intermediate_rect.max_x;
+}
+
+template<typename Context>
+int BasicChunk<Context>::get_asleep_steps() const
+{
+    return m_asleep_steps;
+}
+
+template<typename Context>
+int BasicChunk<Context>::get_index(Point position) const
+{
+    return position.x + position.y * c_width;
+}
+
+template<typename Context>
+int BasicChunk<Context>::get_halo_index(int x, int y) const
+{
+    return (x + c_halo) + (y + c_halo) * c_stride;
+}
+
+template<typename Context>
+int BasicChunk<Context>::get_type_index(int index) const
+{
+    // skip over the halo columns of every row above
+    return get_halo_index(index % c_width, index / c_width);
+}
+
+template<typename Context>
+void BasicChunk<Context>::rebuild_occupancy()
+{
+    m_filled_cells = 0;
+    m_row_masks.fill(0);
+    m_column_counts.fill(0);
+
+    for (int y = 0; y < c_height; y++)
+    {
+        for (int x = 0; x < c_width; x++)
+        {
+            if (is_empty(get_index({ x, y }))) continue;
+
+            m_filled_cells++;
+            m_row_masks[y] |= uint64_t(1) << x;
+            m_column_counts[x]++;
+        }
+    }
+}
+
+template<typename Context>
+int BasicChunk<Context>::get_neighbour_index(int x, int y) const
+{
+    assert(x >= -1 && x <= 1 && y >= -1 && y <= 1 && (x != 0 || y != 0) && "Chunk::get_neighbour_index not a neighbour!");
+
+    // 3x3 block around the chunk without the middle
+    const int index = (x + 1) + (y + 1) * 3;
+
+    return index > 4 ? index - 1 : index;
+}
+
+template<typename Context>
+int BasicChunk<Context>::get_neighbour_slot(const BasicChunk* chunk) const
+{
+    const auto it = std::find(m_neighbours.begin(), m_neighbours.end(), chunk);
+
+    assert(it != m_neighbours.end() && "Chunk::get_neighbour_slot not a neighbour!");
+
+    return static_cast<int>(it - m_neighbours.begin());
+}
+
+template<typename Context>
+void BasicChunk<Context>::set_next_rect(int index)
+{
+    // generate a rect based on the placed tiles
+    int x = index % c_width;
+    int y = index / c_width;
+
+    set_next_rect({
+        std::max(x - 2, 0),
+        std::max(y - 2, 0),
+        std::min(x + 2, c_width - 1),
+        std::min(y + 2, c_height - 1)
+    });
+}
+
+template<typename Context>
+void BasicChunk<Context>::set_next_rect(const IntRect& rect)
+{
+    grow_rect(m_intermediate_rect, rect);
+
+    // and the same for every tile the rect reaches into
+    for (int tile_y = rect.min_y / c_tile_size; tile_y <= rect.max_y / c_tile_size; tile_y++)
+    {
+        for (int tile_x = rect.min_x / c_tile_size; tile_x <= rect.max_x / c_tile_size; tile_x++)
+        {
+            const int tile = tile_x + tile_y * c_tiles_x;
+            const uint64_t tile_bit = uint64_t(1) << tile;
+
+            const IntRect tile_part = {
+                std::max(rect.min_x, tile_x * c_tile_size),
+                std::max(rect.min_y, tile_y * c_tile_size),
+                std::min(rect.max_x, tile_x * c_tile_size + c_tile_size - 1),
+                std::min(rect.max_y, tile_y * c_tile_size + c_tile_size - 1)
+            };
+
+            // the first wake up replaces whatever the tile had before
+            if (m_intermediate_tiles & tile_bit)
+            {
+                grow_rect(m_intermediate_tile_rects[tile], tile_part);
+            }
+            else
+            {
+                m_intermediate_tile_rects[tile] = tile_part;
+                m_intermediate_tiles |= tile_bit;
+            }
+        }
+    }
+}
+
+template<typename Context>
+void BasicChunk<Context>::add_dirty_masks()
+{
+    for (uint64_t tiles = m_dirty_tiles; tiles != 0; tiles &= tiles - 1)
+    {
+        const IntRect& rect = m_dirty_tile_rects[std::countr_zero(tiles)];
+        const uint64_t columns = (~uint64_t(0) >> (63 - rect.max_x)) & (~uint64_t(0) << rect.min_x);
+
+        for (int y = rect.min_y; y <= rect.max_y; y++)
+        {
+            m_dirty_masks[y] |= columns;
+        }
+    }
+}
+
+template<typename Context>
+void BasicChunk<Context>::reset_rect(IntRect& rect) const
+{
+    rect.min_x = c_width;
+    rect.min_y = c_height;
+    rect.max_x = -1;
+    rect.max_y = -1;
+}
+
+template<typename Context>
+void BasicChunk<Context>::grow_rect(IntRect& rect, const IntRect& other)
+{
+    rect.min_x = std::min(rect.min_x, other.min_x);
+    rect.min_y = std::min(rect.min_y, other.min_y);
+    rect.max_x = std::max(rect.max_x, other.max_x);
+    rect.max_y = std::max(rect.max_y, other.max_y);
+}
+
+// the default context is built once in chunk.cpp
+extern template class BasicChunk<ChunkContext>;
+
+using Chunk = BasicChunk<ChunkContext>;
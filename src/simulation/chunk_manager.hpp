@@ -1,26 +1,127 @@
 #pragma once
 
-#include <unordered_map>
-#include <boost/container/static_vector.hpp>
-
-#include <raylib.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "utils/point.hpp"
+#include "utils/counter_random.hpp"
+#include "utils/trace.hpp"
+#include "utils/thread_pool.hpp"
 #include "simulation/chunk.hpp"
+#include "simulation/particle_system.hpp"
+#include "simulation/region_store.hpp"
+#include "simulation/simulation_metrics.hpp"
 #include "core/chunk_context.hpp"
+#include "core/material_registry.hpp"
+
+struct ChunkPoolStats
+{
+    size_t created = 0; // chunks allocated
+    size_t reused = 0;  // chunks taken from the pool
+    size_t retired = 0; // chunks given back to the pool
+    size_t pooled = 0;  // chunks waiting in the pool
+};
+
+struct ChunkPagingStats
+{
+    size_t paged_in = 0;  // chunks read back from disk
+    size_t paged_out = 0; // chunks written to disk and retired
+};
 
-class ChunkManager
+template<typename Context>
+class BasicChunkManager
 {
 public:
-    ChunkManager();
-    ~ChunkManager();
+    using ContextType = Context;
+    using ChunkType = BasicChunk<Context>;
+    // fills a chunk created at a chunk position the world never had a chunk at, can run on any thread
+    using ChunkGenerator = std::function<void(Point chunk_position, ChunkType& chunk)>;
+
+    // more than one thread updates chunks in a checkerboard across a thread pool
+    explicit BasicChunkManager(size_t thread_count = 1);
+    ~BasicChunkManager();
 
-    const Cell* get_cell(int x, int y);  
+    std::optional<Cell> get_cell(int x, int y);  
     void set_cell(int x, int y, const Cell& cell);
     void move_cell(int from_x, int from_y, int to_x, int to_y, bool swap = false);
     bool is_empty(int x, int y) const;
 
     size_t get_total_chunks() const;
+    ChunkPoolStats get_pool_stats() const;
+    size_t get_thread_count() const;
+    std::span<ChunkType* const> get_chunks() const;
+
+    // steps an empty chunk waits before it is retired, stops chunks flickering in and out
+    void set_removal_grace_steps(int steps);
+
+    // the world steps at a fixed rate, fewer steps per second trade detail for keeping up under load
+    void set_step_rate(float steps_per_second);
+    float get_time_step() const;
+
+    // after a slow frame an update runs at most max_steps, and stops early once a step ends past max_seconds
+    // the time it couldnt catch up on is dropped so the world slows down instead of falling further behind
+    // zero seconds means there is no time limit
+    void set_catch_up_limits(int max_steps, float max_seconds);
+    uint64_t get_dropped_steps() const;
+
+    // once more than max_resident_chunks exist, chunks that stayed asleep are written to region files
+    // in directory and retired, they are read back when a chunk is created at their position again
+    void enable_paging(const std::filesystem::path& directory, size_t max_resident_chunks);
+    ChunkPagingStats get_paging_stats() const;
+
+    // reads never page chunks in, bring back stored chunks in a range of chunk positions (e.g. the view)
+    void page_in(Point min_chunk, Point max_chunk);
+    // write every resident chunk so the whole world is on disk
+    void save_resident_chunks();
+
+    // new chunks are filled by the generator, positions that already had a chunk are left alone
+    // so a chunk that was emptied and removed comes back as air
+    void set_generator(ChunkGenerator generator);
+    // creates and fills every chunk in a range of chunk positions that was never generated, spread across the threads
+    void generate_chunks(Point min_chunk, Point max_chunk);
+
+    // the whole simulation state, chunk positions, cells, rects, particles and the time left over from the last step
+    // a loaded world counts as generated everywhere, positions missing from it stay air
+    // while paging, chunks on disk are copied in from the region files without paging them in
+    void save_snapshot(ByteWriter& writer) const;
+    // replaces the world once the whole snapshot has been read, a broken one leaves the world and region files as they were
+    // while paging, the region files of the old world are deleted
+    bool load_snapshot(ByteReader& reader);
+    // true once paging is enabled, the resident chunks are then only part of the world
+    bool is_paging() const;
+    float get_accumulator() const;
+
+    // every random decision is a pure function of the seed, the step and the cell
+    void set_seed(uint64_t seed);
+    uint64_t get_seed() const;
+    uint64_t get_step() const;
+    CounterRandom get_random() const;
+
+    // per step timings and counters, off until enabled
+    SimulationMetrics& get_metrics();
+    const SimulationMetrics& get_metrics() const;
+
+    // the cell is taken out of the grid once the workers are done and flies as a particle until it hits something
+    // safe to call from workers
+    void launch_cell(int x, int y, float velocity_x, float velocity_y);
+    const ParticleSystem& get_particles() const;
+
+    // stored chunks that arent in chunks are copied from the region store if there is one
+    static void write_snapshot(ByteWriter& writer, std::span<const ChunkType* const> chunks, const ParticleSystem& particles, float accumulator, uint64_t seed, uint64_t step, RegionStore* stored = nullptr);
 
 public:
     template<typename ChunkWorker>
@@ -28,68 +129,1375 @@ public:
     {
         m_accumulator += delta_time;
 
+        const auto start = std::chrono::steady_clock::now();
+        int steps = 0;
+
         // update world at a fixed rate 
-        while (m_accumulator > c_time_step)
+        while (m_accumulator > m_time_step)
         {
-            // apply cell logic
-            for (auto* chunk : m_chunks)
+            if (steps == m_max_catch_up_steps || is_over_catch_up_time(start))
             {
-                assert(chunk != nullptr);
-
-                auto tmp = ChunkWorker(*this, chunk);
-                tmp.update_chunk(c_time_step);
+                drop_steps();
+                break;
             }
 
-            // apply moved cells to grid
-            for (auto* chunk : m_chunks)
+            TRACE_SCOPE("step");
+
+            if (m_thread_pool != nullptr)
+            {
+                update_parallel<ChunkWorker>();
+            }
+            else 
             {
-                chunk->apply_moved_cells();
+                update_serial<ChunkWorker>();
             }
 
-            // update the bounds
-            for (auto* chunk : m_chunks)
             {
-                chunk->update_rect();
+                ScopedPhaseTimer timer(m_metrics, MetricPhase::RemoveChunks);
+                TRACE_SCOPE("remove_chunks");
+
+                // remove any empty chunks
+                remove_empty_chunks();
+
+                if (m_region_store != nullptr)
+                {
+                    page_out_chunks();
+                }
             }
 
-            // remove any empty chunks
-            remove_empty_chunks();
+            if (m_metrics.is_enabled())
+            {
+                count_chunk_states();
+                m_metrics.end_step();
+            }
 
-            m_accumulator -= c_time_step;
+            m_accumulator -= m_time_step;
+            m_step++;
+            steps++;
         }
     }
 
-    void pre_draw(const Rectangle& view);
-    void draw(const Rectangle& view, bool debug = false);
-
 public:
+    // how far past its dirty rect a worker may read or move cells, further out a missing chunk is a wall in a parallel update
+    static constexpr int c_worker_reach = 8;
+
     Point pos_to_grid(float x, float y) const;
     Point grid_to_chunk(int x, int y) const;
     Point grid_to_chunk_local(int x, int y) const;
     Point world_to_chunk(float x, float y) const;
 
 private:
-    bool in_world_bounds(const Point& chunk_position);
-    bool is_chunk_in_view(const Chunk* chunk, const Rectangle& view) const;
+    // fewer chunks than this run on the calling thread, a barrier costs more than they take
+    static constexpr size_t c_min_parallel_phase = 2;
+    static constexpr size_t c_min_parallel_halos = 32;
+    static constexpr size_t c_min_parallel_rects = 256;
+
+    template<typename ChunkWorker>
+    void update_serial()
+    {
+        {
+            ScopedPhaseTimer timer(m_metrics, MetricPhase::Update);
+            TRACE_SCOPE("update");
+
+            // a paged out chunk reads as air, so bring back everything the workers can reach
+            if (m_region_store != nullptr)
+            {
+                create_reachable_chunks();
+            }
+
+            split_into_phases();
+
+            // take a copy of the neighbours borders
+            for (auto* chunk : m_awake_chunks)
+            {
+                chunk->refresh_halo();
+            }
+
+            // apply cell logic in the phases a parallel update uses, workers change the grid when a cell's life
+            // time runs out, so neighbours have to see those changes in the same order
+            for (auto& phase : m_phases)
+            {
+                for (auto* chunk : phase)
+                {
+                    assert(chunk != nullptr);
+
+                    auto tmp = ChunkWorker(*this, chunk);
+                    tmp.update_chunk(m_time_step);
+                }
+            }
+
+            lift_launched_cells();
+        }
+
+        {
+            ScopedPhaseTimer timer(m_metrics, MetricPhase::ApplyMoves);
+            TRACE_SCOPE("apply_moves");
+
+            // apply moved cells to grid, in the same phases as a parallel update so both give the same world
+            split_moves_into_phases();
+
+            for (auto& phase : m_phases)
+            {
+                for (auto* chunk : phase)
+                {
+                    apply_moved_cells(chunk, get_random());
+                }
+            }
+        }
+
+        {
+            ScopedPhaseTimer timer(m_metrics, MetricPhase::Particles);
+            TRACE_SCOPE("particles");
+
+            update_particles();
+        }
+
+        {
+            ScopedPhaseTimer timer(m_metrics, MetricPhase::UpdateRect);
+            TRACE_SCOPE("update_rect");
+
+            // update the bounds
+            for (auto* chunk : m_chunks)
+            {
+                chunk->update_rect();
+            }
+        }
+    }
+
+    template<typename ChunkWorker>
+    void update_parallel()
+    {
+        const CounterRandom random = get_random();
+
+        {
+            ScopedPhaseTimer timer(m_metrics, MetricPhase::Update);
+            TRACE_SCOPE("update");
+
+            // chunks can't be created while workers are reading the slots
+            create_reachable_chunks();
+            split_into_phases();
+
+            m_updating = true;
+
+            // take a copy of the neighbours borders, nothing writes to the grids yet
+            // the halo has to be taken before any phase writes, so this cant join the first phase
+            for_each_chunk(m_awake_chunks, c_min_parallel_halos, [&](ChunkType* chunk)
+            {
+                chunk->refresh_halo();
+            });
+
+            // apply cell logic, chunks sharing an edge or corner never run at the same time
+            for (auto& phase : m_phases)
+            {
+                for_each_chunk(phase, c_min_parallel_phase, [&](ChunkType* chunk)
+                {
+                    auto tmp = ChunkWorker(*this, chunk);
+                    tmp.update_chunk(m_time_step);
+                });
+            }
+
+            lift_launched_cells();
+        }
+
+        {
+            ScopedPhaseTimer timer(m_metrics, MetricPhase::ApplyMoves);
+            TRACE_SCOPE("apply_moves");
+
+            // apply moved cells to grid, this writes back into the source chunks
+            split_moves_into_phases();
+
+            for (auto& phase : m_phases)
+            {
+                for_each_chunk(phase, c_min_parallel_phase, [&](ChunkType* chunk)
+                {
+                    apply_moved_cells(chunk, random);
+                });
+            }
+        }
+
+        // particles land anywhere, so chunks can be created again
+        m_updating = false;
+
+        {
+            ScopedPhaseTimer timer(m_metrics, MetricPhase::Particles);
+            TRACE_SCOPE("particles");
+
+            update_particles();
+        }
+
+        {
+            ScopedPhaseTimer timer(m_metrics, MetricPhase::UpdateRect);
+            TRACE_SCOPE("update_rect");
+
+            // update the bounds, any chunk can have been woken up so this goes over all of them
+            // after the particles landed, they can wake up chunks too
+            for_each_chunk(m_chunks, c_min_parallel_rects, [](ChunkType* chunk)
+            {
+                chunk->update_rect();
+            });
+        }
+    }
+
+    // runs task on every chunk, only hands them to the pool when there are enough to be worth the barrier
+    template<typename Task>
+    void for_each_chunk(const std::vector<ChunkType*>& chunks, size_t min_parallel, const Task& task)
+    {
+        if (chunks.size() < min_parallel)
+        {
+            for (auto* chunk : chunks)
+            {
+                task(chunk);
+            }
+
+            return;
+        }
+
+        m_thread_pool->parallel_for(chunks.size(), [&](size_t i)
+        {
+            task(chunks[i]);
+        });
+    }
+
+    void apply_moved_cells(ChunkType* chunk, const CounterRandom& random);
+    void count_chunk_states();
+    bool is_over_catch_up_time(std::chrono::steady_clock::time_point start) const;
+    void drop_steps();
+
+    void lift_launched_cells();
+    void update_particles();
+    bool can_fly_through(int x, int y);
+    void create_reachable_chunks();
+    void split_into_phases();
+    void split_moves_into_phases();
 
-    Chunk* create_chunk(Point chunk_position);
-    Chunk* get_chunk_or_create(Point chunk_position);
+    bool in_world_bounds(const Point& chunk_position) const;
+    bool is_generated(const Point& chunk_position) const;
+    Point get_chunk_position(const ChunkType* chunk) const;
+
+    struct SlotPage;
+    SlotPage* get_slot_page(const Point& chunk_position) const;
+    SlotPage& get_or_create_slot_page(const Point& chunk_position);
+    int get_slot_index(const Point& chunk_position) const;
+
+    ChunkType* get_chunk(Point chunk_position) const;
+    // fill is false when the caller fills the chunk itself, it then starts empty without paging in or generating
+    ChunkType* create_chunk(Point chunk_position, bool fill = true);
+    // a pooled or new chunk that isnt in the world yet
+    ChunkType* take_chunk(Point chunk_position);
+    ChunkType* insert_chunk(Point chunk_position, ChunkType* chunk);
+    ChunkType* get_chunk_or_create(Point chunk_position);
+    void link_neighbours(ChunkType* chunk, Point chunk_position, bool link);
+    void retire_chunk(ChunkType* chunk);
+    void clear_chunks();
     void remove_empty_chunks();
+    bool can_page_out(const ChunkType* chunk) const;
+    void page_out_chunks();
     void wake_up_chunk(int x, int y);
 
 private:
-    static constexpr int c_width = ChunkContext::width;
-    static constexpr int c_height = ChunkContext::height;
-    static constexpr int c_cell_size = ChunkContext::cell_size;
+    static constexpr int c_width = Context::width;
+    static constexpr int c_height = Context::height;
+    static constexpr int c_cell_size = Context::cell_size;
+
+    static constexpr Point c_min_chunk_pos = Context::min_chunk_pos;
+    static constexpr Point c_max_chunk_pos = Context::max_chunk_pos;
+    static constexpr int64_t c_world_width = static_cast<int64_t>(c_max_chunk_pos.x) - c_min_chunk_pos.x + 1;
+    static constexpr int64_t c_world_height = static_cast<int64_t>(c_max_chunk_pos.y) - c_min_chunk_pos.y + 1;
+
+    // chunk slots come in pages of up to 64x64 chunk positions, small worlds fit in one page
+    static constexpr int c_page_width = static_cast<int>(std::min<int64_t>(64, c_world_width));
+    static constexpr int c_page_height = static_cast<int>(std::min<int64_t>(64, c_world_height));
+    static constexpr int64_t c_pages_wide = (c_world_width + c_page_width - 1) / c_page_width;
+    static constexpr int64_t c_pages_high = (c_world_height + c_page_height - 1) / c_page_height;
 
-    static constexpr Point c_min_chunk_pos = ChunkContext::min_chunk_pos;
-    static constexpr Point c_max_chunk_pos = ChunkContext::max_chunk_pos;
-    static constexpr int c_max_chunks = ChunkContext::max_chunks;
+    static_assert(c_pages_wide * c_pages_high <= (1 << 20), "the world is too big for the chunk page directory");
+
+    static constexpr uint32_t c_snapshot_magic = 0x504E5353; // "SSNP"
+    static constexpr uint32_t c_snapshot_version = 4;
+
+    // cells per step per step, the same pull workers give falling cells
+    static constexpr float c_gravity = 1.0f;
 
 private:
-    const float c_time_step = 1.0f / 60.0f;
+    float m_time_step = 1.0f / 60.0f;
     float m_accumulator = 0;
+    int m_max_catch_up_steps = 8;
+    float m_max_catch_up_seconds = 0;
+    uint64_t m_dropped_steps = 0;
+    uint64_t m_seed = 0;
+    uint64_t m_step = 0;
+
+    // every chunk position has a slot, nullptr when it doesnt exist
+    // a page of slots is only allocated once a chunk is created in it, so a wide world only costs the directory
+    struct SlotPage
+    {
+        std::array<ChunkType*, c_page_width * c_page_height> chunks = {};
+        std::bitset<c_page_width * c_page_height> generated; // positions that had a chunk at some point
+    };
+
+    std::vector<std::unique_ptr<SlotPage>> m_slot_pages;
+    std::vector<ChunkType*> m_chunks;
+
+    // retired chunks are kept around and handed out again
+    std::vector<ChunkType*> m_chunk_pool;
+    ChunkPoolStats m_pool_stats;
+    int m_removal_grace_steps = 30;
+
+    // chunks past the resident limit live on disk
+    std::unique_ptr<RegionStore> m_region_store;
+    size_t m_max_resident_chunks = 0;
+    ChunkPagingStats m_paging_stats;
+    std::vector<ChunkType*> m_page_out_candidates;
+
+    // only positions that never had a chunk are generated
+    // a loaded snapshot is the whole world, so after one nothing is generated at all
+    ChunkGenerator m_generator;
+    bool m_generated_everywhere = false;
+
+    // airborne cells, launches are collected from the workers and lifted out of the grid after they finish
+    struct Launch
+    {
+        Point position;
+        float velocity_x = 0;
+        float velocity_y = 0;
+    };
+
+    ParticleSystem m_particles;
+    std::mutex m_launch_mutex;
+    std::vector<Launch> m_launches;
+
+    SimulationMetrics m_metrics;
+
+    std::unique_ptr<ThreadPool> m_thread_pool;
+    std::array<std::vector<ChunkType*>, 4> m_phases;
+    std::vector<ChunkType*> m_awake_chunks;
+    bool m_updating = false;
+};
+
+template<typename Context>
+BasicChunkManager<Context>::BasicChunkManager(size_t thread_count)
+    : m_slot_pages(c_pages_wide * c_pages_high)
+{
+    if (thread_count > 1)
+    {
+        m_thread_pool = std::make_unique<ThreadPool>(thread_count);
+    }
+}
+
+template<typename Context>
+BasicChunkManager<Context>::~BasicChunkManager()
+{
+    for (auto* chunk : m_chunks)
+    {
+        delete chunk;
+    }
+
+    for (auto* chunk : m_chunk_pool)
+    {
+        delete chunk;
+    }
+}
+
+template<typename Context>
+std::optional<Cell> BasicChunkManager<Context>::get_cell(int x, int y)
+{
+    const Point chunk_position = grid_to_chunk(x, y);
+
+    // not in bounds of world
+    if (!in_world_bounds(chunk_position)) return std::nullopt;
+
+    // reading never creates a chunk, missing ones are just air
+    if (const ChunkType* chunk = get_chunk(chunk_position))
+    {
+        return chunk->get_cell(grid_to_chunk_local(x, y));
+    } 
+
+    // unless workers are running, then it cant be created and is a wall like the world edge
+    if (m_updating) return std::nullopt;
+
+    return Cell();
+}    
+
+template<typename Context>
+void BasicChunkManager<Context>::set_cell(int x, int y, const Cell& cell)
+{
+    const Point chunk_position = grid_to_chunk(x, y);
+    const Point local_position = grid_to_chunk_local(x, y);
+
+    if (ChunkType* chunk = get_chunk_or_create(chunk_position))
+    {  
+        chunk->set_cell(local_position, cell);
+    }
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::move_cell(int from_x, int from_y, int to_x, int to_y, bool swap)
+{
+    const Point from_chunk_pos = grid_to_chunk(from_x, from_y);
+    const Point to_chunk_pos = grid_to_chunk(to_x, to_y);
+
+    ChunkType* from_chunk = get_chunk_or_create(from_chunk_pos);
+    ChunkType* to_chunk = get_chunk_or_create(to_chunk_pos);
+
+    if (from_chunk != nullptr && to_chunk != nullptr)
+    {
+        const Point from_local = grid_to_chunk_local(from_x, from_y);
+        const Point to_local = grid_to_chunk_local(to_x, to_y);
+        Point notify;
+
+        // get chunk offset if local pos is at the edges
+        if (from_local.x == 0)            notify.x = -1;
+        if (from_local.x == c_width - 1)  notify.x = +1;
+        if (from_local.y == 0)            notify.y = -1;
+        if (from_local.y == c_height - 1) notify.y = +1;
+
+        // notify neighour chunks
+        if (notify.x != 0)                  wake_up_chunk(from_x + notify.x, from_y);
+        if (notify.y != 0)                  wake_up_chunk(from_x, from_y + notify.y);
+        if (notify.x != 0 && notify.y != 0) wake_up_chunk(from_x + notify.x, from_y + notify.y);
+
+        // move cell
+        to_chunk->move_cell(from_local, to_local, swap, from_chunk);
+    }
+}
+
+template<typename Context>
+bool BasicChunkManager<Context>::is_empty(int x, int y) const
+{
+    const Point chunk_position = grid_to_chunk(x, y);
+
+    if (const ChunkType* chunk = get_chunk(chunk_position))
+    {
+        return chunk->is_empty(grid_to_chunk_local(x, y));
+    }
+
+    return true;
+}
+
+template<typename Context>
+size_t BasicChunkManager<Context>::get_total_chunks() const
+{
+    return m_chunks.size();
+}
+
+template<typename Context>
+ChunkPoolStats BasicChunkManager<Context>::get_pool_stats() const
+{
+    ChunkPoolStats stats = m_pool_stats;
+    stats.pooled = m_chunk_pool.size();
+
+    return stats;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::set_removal_grace_steps(int steps)
+{
+    m_removal_grace_steps = steps;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::set_step_rate(float steps_per_second)
+{
+    assert(steps_per_second > 0 && "ChunkManager::set_step_rate needs a positive rate!");
+
+    m_time_step = 1.0f / steps_per_second;
+}
+
+template<typename Context>
+float BasicChunkManager<Context>::get_time_step() const
+{
+    return m_time_step;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::set_catch_up_limits(int max_steps, float max_seconds)
+{
+    assert(max_steps > 0 && "ChunkManager::set_catch_up_limits needs at least one step!");
+
+    m_max_catch_up_steps = max_steps;
+    m_max_catch_up_seconds = max_seconds;
+}
+
+template<typename Context>
+uint64_t BasicChunkManager<Context>::get_dropped_steps() const
+{
+    return m_dropped_steps;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::enable_paging(const std::filesystem::path& directory, size_t max_resident_chunks)
+{
+    m_region_store = std::make_unique<RegionStore>(directory);
+    m_max_resident_chunks = max_resident_chunks;
+}
+
+template<typename Context>
+ChunkPagingStats BasicChunkManager<Context>::get_paging_stats() const
+{
+    return m_paging_stats;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::set_generator(ChunkGenerator generator)
+{
+    m_generator = std::move(generator);
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::generate_chunks(Point min_chunk, Point max_chunk)
+{
+    assert(!m_updating && "ChunkManager::generate_chunks called during an update!");
+
+    if (!m_generator) return;
+
+    struct Pending
+    {
+        Point chunk_position;
+        ChunkType* chunk = nullptr;
+    };
+
+    std::vector<Pending> pending;
+
+    // creating chunks touches the slots and neighbours, so that part stays on this thread
+    for (int y = std::max(min_chunk.y, c_min_chunk_pos.y); y <= std::min(max_chunk.y, c_max_chunk_pos.y); y++)
+    {
+        for (int x = std::max(min_chunk.x, c_min_chunk_pos.x); x <= std::min(max_chunk.x, c_max_chunk_pos.x); x++)
+        {
+            if (get_chunk({ x, y }) != nullptr || is_generated({ x, y })) continue;
+
+            // chunks on disk are paged in when they are needed
+            if (m_region_store != nullptr && m_region_store->has_chunk({ x, y })) continue;
+
+            pending.push_back({ { x, y }, create_chunk({ x, y }, false) });
+        }
+    }
+
+    // each chunk only writes its own cells
+    const auto fill = [&](size_t i)
+    {
+        m_generator(pending[i].chunk_position, *pending[i].chunk);
+    };
+
+    if (m_thread_pool != nullptr)
+    {
+        m_thread_pool->parallel_for(pending.size(), fill);
+    }
+    else
+    {
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            fill(i);
+        }
+    }
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::page_in(Point min_chunk, Point max_chunk)
+{
+    if (m_region_store == nullptr) return;
+
+    for (int y = std::max(min_chunk.y, c_min_chunk_pos.y); y <= std::min(max_chunk.y, c_max_chunk_pos.y); y++)
+    {
+        for (int x = std::max(min_chunk.x, c_min_chunk_pos.x); x <= std::min(max_chunk.x, c_max_chunk_pos.x); x++)
+        {
+            if (get_chunk({ x, y }) == nullptr && m_region_store->has_chunk({ x, y }))
+            {
+                create_chunk({ x, y });
+            }
+        }
+    }
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::save_resident_chunks()
+{
+    if (m_region_store == nullptr) return;
+
+    for (const auto* chunk : m_chunks)
+    {
+        const Point chunk_position = get_chunk_position(chunk);
+
+        // empty chunks are the same as no chunk
+        if (chunk->should_remove())
+        {
+            m_region_store->erase_chunk(chunk_position);
+        }
+        else 
+        {
+            m_region_store->save_chunk(chunk_position, *chunk);
+        }
+    }
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::save_snapshot(ByteWriter& writer) const
+{
+    write_snapshot(writer, { m_chunks.data(), m_chunks.size() }, m_particles, m_accumulator, m_seed, m_step, m_region_store.get());
+}
+
+template<typename Context>
+bool BasicChunkManager<Context>::load_snapshot(ByteReader& reader)
+{
+    assert(!m_updating && "ChunkManager::load_snapshot called during an update!");
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    float accumulator = 0;
+    uint64_t seed = 0;
+    uint64_t step = 0;
+    uint32_t chunk_count = 0;
+
+    const bool valid_header = 
+        reader.read(magic) && reader.read(version) && reader.read(width) && reader.read(height) && 
+        reader.read(accumulator) && reader.read(seed) && reader.read(step) && reader.read(chunk_count) &&
+        magic == c_snapshot_magic && version == c_snapshot_version && width == c_width && height == c_height;
+
+    if (!valid_header) return false;
+
+    // everything is read into chunks off to the side, the world is only touched once the whole snapshot is good
+    std::vector<std::pair<Point, ChunkType*>> staged;
+    std::unordered_set<Point> staged_positions;
+    ParticleSystem particles;
+
+    const auto discard = [&]()
+    {
+        for (const auto& [chunk_position, chunk] : staged)
+        {
+            m_chunk_pool.push_back(chunk);
+        }
+
+        return false;
+    };
+
+    for (uint32_t i = 0; i < chunk_count; i++)
+    {
+        Point position;
+        uint32_t size = 0;
+        std::span<const uint8_t> bytes;
+
+        if (!reader.read(position) || !reader.read(size) || !reader.read_span(size, bytes)) return discard();
+
+        const Point chunk_position = world_to_chunk(position.x, position.y);
+
+        if (!in_world_bounds(chunk_position) || !staged_positions.insert(chunk_position).second) return discard();
+
+        ChunkType* chunk = staged.emplace_back(chunk_position, take_chunk(chunk_position)).second;
+
+        // each chunk is read on its own so a bad one cant read into the next
+        ByteReader chunk_reader(bytes);
+
+        if (chunk->get_position() != position || !chunk->deserialize(chunk_reader)) return discard();
+    }
+
+    if (!particles.deserialize(reader)) return discard();
+
+    clear_chunks();
+
+    if (m_region_store != nullptr)
+    {
+        m_region_store->clear();
+    }
+
+    // the snapshot has the whole world, nothing is filled in around it
+    m_generated_everywhere = true;
+
+    for (const auto& [chunk_position, chunk] : staged)
+    {
+        insert_chunk(chunk_position, chunk);
+    }
+
+    m_particles = std::move(particles);
+    m_accumulator = accumulator;
+    m_seed = seed;
+    m_step = step;
+
+    return true;
+}
+
+template<typename Context>
+bool BasicChunkManager<Context>::is_paging() const
+{
+    return m_region_store != nullptr;
+}
+
+template<typename Context>
+float BasicChunkManager<Context>::get_accumulator() const
+{
+    return m_accumulator;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::set_seed(uint64_t seed)
+{
+    m_seed = seed;
+}
+
+template<typename Context>
+uint64_t BasicChunkManager<Context>::get_seed() const
+{
+    return m_seed;
+}
+
+template<typename Context>
+uint64_t BasicChunkManager<Context>::get_step() const
+{
+    return m_step;
+}
+
+template<typename Context>
+CounterRandom BasicChunkManager<Context>::get_random() const
+{
+    return CounterRandom(m_seed, m_step);
+}
+
+template<typename Context>
+SimulationMetrics& BasicChunkManager<Context>::get_metrics()
+{
+    return m_metrics;
+}
+
+template<typename Context>
+const SimulationMetrics& BasicChunkManager<Context>::get_metrics() const
+{
+    return m_metrics;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::launch_cell(int x, int y, float velocity_x, float velocity_y)
+{
+    std::lock_guard lock(m_launch_mutex);
+
+    m_launches.push_back({ { x, y }, velocity_x, velocity_y });
+}
+
+template<typename Context>
+const ParticleSystem& BasicChunkManager<Context>::get_particles() const
+{
+    return m_particles;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::write_snapshot(ByteWriter& writer, std::span<const ChunkType* const> chunks, const ParticleSystem& particles, float accumulator, uint64_t seed, uint64_t step, RegionStore* stored)
+{
+    // paged out chunks, a resident chunk may still have an older copy on disk
+    std::vector<Point> paged_out;
+
+    if (stored != nullptr)
+    {
+        std::unordered_set<Point> resident;
+
+        for (const ChunkType* chunk : chunks)
+        {
+            resident.insert(Context::cell_to_chunk(chunk->get_position().x / c_cell_size, chunk->get_position().y / c_cell_size));
+        }
+
+        for (const Point chunk_position : stored->get_stored_chunks())
+        {
+            if (!resident.contains(chunk_position)) paged_out.push_back(chunk_position);
+        }
+    }
+
+    writer.write(c_snapshot_magic);
+    writer.write(c_snapshot_version);
+    writer.write(static_cast<uint16_t>(c_width));
+    writer.write(static_cast<uint16_t>(c_height));
+    writer.write(accumulator);
+    writer.write(seed);
+    writer.write(step);
+
+    const size_t count_offset = writer.get_size();
+    uint32_t count = 0;
+    writer.write(count);
+
+    for (const ChunkType* chunk : chunks)
+    {
+        writer.write(chunk->get_position());
+
+        // the size goes in front, filled in once the chunk is written
+        const size_t size_offset = writer.get_size();
+        writer.write(uint32_t(0));
+
+        chunk->serialize(writer);
+        writer.write_at(size_offset, static_cast<uint32_t>(writer.get_size() - size_offset - sizeof(uint32_t)));
+        count++;
+    }
+
+    // the region files hold chunks serialized the same way, so their bytes go in as they are
+    for (const Point chunk_position : paged_out)
+    {
+        std::span<const uint8_t> bytes;
+
+        if (!stored->get_chunk_bytes(chunk_position, bytes)) continue;
+
+        writer.write(Point(chunk_position.x * c_width * c_cell_size, chunk_position.y * c_height * c_cell_size));
+        writer.write(static_cast<uint32_t>(bytes.size()));
+        writer.write_bytes(bytes.data(), bytes.size());
+        count++;
+    }
+
+    writer.write_at(count_offset, count);
+
+    particles.serialize(writer);
+}
+
+template<typename Context>
+size_t BasicChunkManager<Context>::get_thread_count() const
+{
+    return m_thread_pool != nullptr ? m_thread_pool->get_thread_count() : 1;
+}
+
+template<typename Context>
+std::span<BasicChunk<Context>* const> BasicChunkManager<Context>::get_chunks() const
+{
+    return { m_chunks.data(), m_chunks.size() };
+}
+
+template<typename Context>
+Point BasicChunkManager<Context>::pos_to_grid(float x, float y) const
+{
+    return { 
+        static_cast<int>(std::floor(x / c_cell_size)), 
+        static_cast<int>(std::floor(y / c_cell_size)) 
+    };
+}    
+
+template<typename Context>
+Point BasicChunkManager<Context>::grid_to_chunk(int x, int y) const
+{
+    return Context::cell_to_chunk(x, y);
+}
+
+template<typename Context>
+Point BasicChunkManager<Context>::grid_to_chunk_local(int x, int y) const
+{
+    return Context::cell_to_local(x, y);
+}
+
+template<typename Context>
+Point BasicChunkManager<Context>::world_to_chunk(float x, float y) const
+{
+    return {
+        static_cast<int>(std::floor(x / (c_width * c_cell_size))),
+        static_cast<int>(std::floor(y / (c_height * c_cell_size)))
+    };
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::apply_moved_cells(ChunkType* chunk, const CounterRandom& random)
+{
+    const int queued = chunk->get_queued_moves();
+    const int applied = chunk->apply_moved_cells(random);
+
+    m_metrics.add_moves(queued, applied);
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::count_chunk_states()
+{
+    uint64_t awake = 0;
+    uint64_t tiles_awake = 0;
+
+    for (const auto* chunk : m_chunks)
+    {
+        if (!chunk->is_asleep()) awake++;
+
+        tiles_awake += std::popcount(chunk->get_awake_tiles());
+    }
+
+    m_metrics.set_chunk_states(awake, m_chunks.size() - awake, tiles_awake);
+}
+
+template<typename Context>
+bool BasicChunkManager<Context>::is_over_catch_up_time(std::chrono::steady_clock::time_point start) const
+{
+    if (m_max_catch_up_seconds <= 0) return false;
+
+    return std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count() > m_max_catch_up_seconds;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::drop_steps()
+{
+    // keep the part of a step that is left over so the rate stays even
+    const float dropped = std::floor(m_accumulator / m_time_step);
+
+    m_accumulator -= dropped * m_time_step;
+    m_dropped_steps += static_cast<uint64_t>(dropped);
+    m_metrics.add_steps_dropped(static_cast<uint64_t>(dropped));
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::lift_launched_cells()
+{
+    if (m_launches.empty()) return;
+
+    // workers launch in any order, sorting keeps the particles the same for any thread count
+    std::sort(m_launches.begin(), m_launches.end(), [](const Launch& a, const Launch& b)
+    {
+        return a.position.y != b.position.y ? a.position.y < b.position.y : a.position.x < b.position.x;
+    });
+
+    for (const Launch& launch : m_launches)
+    {
+        const Point position = launch.position;
+        ChunkType* chunk = get_chunk(grid_to_chunk(position.x, position.y));
+        const Point local_position = grid_to_chunk_local(position.x, position.y);
+
+        if (chunk == nullptr || chunk->is_empty(local_position)) continue;
+
+        Cell cell = chunk->get_cell(local_position);
+        cell.velocity = Point::zero();
+
+        const float max_speed = static_cast<float>(MaterialRegistry::get().get_material(cell.type).max_speed);
+
+        // particles start in the middle of their cell, the worker already added this step's gravity
+        m_particles.add(cell, position.x + 0.5f, position.y + 0.5f, launch.velocity_x, launch.velocity_y - c_gravity, max_speed);
+        chunk->set_cell(local_position, Cell());
+
+        // whatever rested on the cell can fall now, even from the chunk above
+        wake_up_chunk(position.x - 1, position.y - 1);
+        wake_up_chunk(position.x, position.y - 1);
+        wake_up_chunk(position.x + 1, position.y - 1);
+    }
+
+    m_launches.clear();
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::update_particles()
+{
+    if (m_particles.empty())
+    {
+        m_metrics.set_particles(0, 0);
+        return;
+    }
+
+    const size_t landed = m_particles.update(c_gravity, m_time_step, 
+        [this](int x, int y) { return can_fly_through(x, y); }, 
+        [this](int x, int y, const Cell& cell) { set_cell(x, y, cell); }
+    );
+
+    m_metrics.set_particles(m_particles.size(), landed);
+}
+
+template<typename Context>
+bool BasicChunkManager<Context>::can_fly_through(int x, int y)
+{
+    const Point chunk_position = grid_to_chunk(x, y);
+
+    // the world edge is a wall
+    if (!in_world_bounds(chunk_position)) return false;
+
+    const ChunkType* chunk = get_chunk(chunk_position);
+
+    // a paged out chunk has to come back before anything can fly through it
+    if (chunk == nullptr && m_region_store != nullptr && m_region_store->has_chunk(chunk_position))
+    {
+        chunk = create_chunk(chunk_position);
+    }
+
+    return chunk == nullptr || chunk->is_empty(grid_to_chunk_local(x, y));
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::create_reachable_chunks()
+{
+    // new chunks are appended, so only look at the ones that existed before
+    const size_t total_chunks = m_chunks.size();
+
+    for (size_t i = 0; i < total_chunks; i++)
+    {
+        const ChunkType* chunk = m_chunks[i];
+        const IntRect& rect = chunk->get_current_rect();
+
+        // asleep, wont touch anything
+        if (rect.min_x > rect.max_x || rect.min_y > rect.max_y) continue;
+
+        const Point chunk_position = get_chunk_position(chunk);
+
+        // figure out which edges the worker can reach past
+        const int reach_min_x = rect.min_x < c_worker_reach ? -1 : 0;
+        const int reach_min_y = rect.min_y < c_worker_reach ? -1 : 0;
+        const int reach_max_x = rect.max_x >= c_width - c_worker_reach ? +1 : 0;
+        const int reach_max_y = rect.max_y >= c_height - c_worker_reach ? +1 : 0;
+
+        for (int y = reach_min_y; y <= reach_max_y; y++)
+        {
+            for (int x = reach_min_x; x <= reach_max_x; x++)
+            {
+                get_chunk_or_create({ chunk_position.x + x, chunk_position.y + y });
+            }
+        }
+    }
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::split_into_phases()
+{
+    for (auto& phase : m_phases)
+    {
+        phase.clear();
+    }
+
+    m_awake_chunks.clear();
+
+    // 2x2 checkerboard, chunks in the same phase are always a chunk apart
+    // asleep chunks have nothing to update, so they dont cost a phase anything
+    for (auto* chunk : m_chunks)
+    {
+        const IntRect& rect = chunk->get_current_rect();
+
+        if (rect.min_x > rect.max_x || rect.min_y > rect.max_y) continue;
+
+        const Point chunk_position = get_chunk_position(chunk);
+
+        m_phases[(chunk_position.x & 1) + (chunk_position.y & 1) * 2].push_back(chunk);
+        m_awake_chunks.push_back(chunk);
+    }
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::split_moves_into_phases()
+{
+    for (auto& phase : m_phases)
+    {
+        phase.clear();
+    }
+
+    // moves can land in asleep chunks too, but only chunks with moves queued have anything to apply
+    for (auto* chunk : m_chunks)
+    {
+        if (chunk->get_queued_moves() == 0) continue;
+
+        const Point chunk_position = get_chunk_position(chunk);
+
+        m_phases[(chunk_position.x & 1) + (chunk_position.y & 1) * 2].push_back(chunk);
+    }
+}
+
+template<typename Context>
+bool BasicChunkManager<Context>::in_world_bounds(const Point& chunk_position) const
+{
+    return (
+        chunk_position.x >= c_min_chunk_pos.x && 
+        chunk_position.x <= c_max_chunk_pos.x &&
+        chunk_position.y >= c_min_chunk_pos.y && 
+        chunk_position.y <= c_max_chunk_pos.y
+    );
+}
+
+template<typename Context>
+bool BasicChunkManager<Context>::is_generated(const Point& chunk_position) const
+{
+    if (m_generated_everywhere) return true;
+
+    const SlotPage* page = get_slot_page(chunk_position);
+
+    return page != nullptr && page->generated[get_slot_index(chunk_position)];
+}
+
+template<typename Context>
+Point BasicChunkManager<Context>::get_chunk_position(const ChunkType* chunk) const
+{
+    // chunk positions are always a multiple of the chunk size
+    const Point position = chunk->get_position();
+
+    return {
+        position.x / (c_width * c_cell_size),
+        position.y / (c_height * c_cell_size)
+    };
+}
+
+template<typename Context>
+typename BasicChunkManager<Context>::SlotPage* BasicChunkManager<Context>::get_slot_page(const Point& chunk_position) const
+{
+    assert(in_world_bounds(chunk_position) && "ChunkManager::get_slot_page out of bounds!");
+
+    const int64_t x = static_cast<int64_t>(chunk_position.x) - c_min_chunk_pos.x;
+    const int64_t y = static_cast<int64_t>(chunk_position.y) - c_min_chunk_pos.y;
+
+    return m_slot_pages[x / c_page_width + (y / c_page_height) * c_pages_wide].get();
+}
+
+template<typename Context>
+typename BasicChunkManager<Context>::SlotPage& BasicChunkManager<Context>::get_or_create_slot_page(const Point& chunk_position)
+{
+    const int64_t x = static_cast<int64_t>(chunk_position.x) - c_min_chunk_pos.x;
+    const int64_t y = static_cast<int64_t>(chunk_position.y) - c_min_chunk_pos.y;
+
+    std::unique_ptr<SlotPage>& page = m_slot_pages[x / c_page_width + (y / c_page_height) * c_pages_wide];
+
+    // pages are kept once allocated, the chunks in them tend to come back
+    if (page == nullptr)
+    {
+        page = std::make_unique<SlotPage>();
+    }
+
+    return *page;
+}
+
+template<typename Context>
+int BasicChunkManager<Context>::get_slot_index(const Point& chunk_position) const
+{
+    const int64_t x = static_cast<int64_t>(chunk_position.x) - c_min_chunk_pos.x;
+    const int64_t y = static_cast<int64_t>(chunk_position.y) - c_min_chunk_pos.y;
+
+    return static_cast<int>(x % c_page_width + (y % c_page_height) * c_page_width);
+}
+
+template<typename Context>
+BasicChunk<Context>* BasicChunkManager<Context>::get_chunk(Point chunk_position) const
+{
+    if (!in_world_bounds(chunk_position)) return nullptr;
+
+    const SlotPage* page = get_slot_page(chunk_position);
+
+    return page != nullptr ? page->chunks[get_slot_index(chunk_position)] : nullptr;
+}
+
+template<typename Context>
+BasicChunk<Context>* BasicChunkManager<Context>::create_chunk(Point chunk_position, bool fill)
+{
+    // only create a chunk in the world bounds
+    if (!in_world_bounds(chunk_position)) return nullptr;
+
+    // the slots are read by every worker, a worker reaching past c_worker_reach finds a wall instead
+    if (m_updating) return nullptr;
+
+    ChunkType* chunk = take_chunk(chunk_position);
+
+    // bring back a chunk that was paged out
+    if (fill && m_region_store != nullptr && m_region_store->has_chunk(chunk_position))
+    {
+        if (m_region_store->load_chunk(chunk_position, *chunk))
+        {
+            m_paging_stats.paged_in++;
+        }
+        else 
+        {
+            // unreadable, start again from an empty chunk
+            chunk->reset(chunk->get_position());
+        }
+    }
+    else if (fill && m_generator && !is_generated(chunk_position))
+    {
+        m_generator(chunk_position, *chunk);
+    }
+
+    return insert_chunk(chunk_position, chunk);
+}
+
+template<typename Context>
+BasicChunk<Context>* BasicChunkManager<Context>::take_chunk(Point chunk_position)
+{
+    // create chunk at world position
+    const Point position = {
+        chunk_position.x * c_width * c_cell_size,
+        chunk_position.y * c_height * c_cell_size,
+    };
+
+    // recycle a retired chunk before allocating a new one
+    if (!m_chunk_pool.empty())
+    {
+        ChunkType* chunk = m_chunk_pool.back();
+        chunk->reset(position);
+
+        m_chunk_pool.pop_back();
+        m_pool_stats.reused++;
+
+        return chunk;
+    }
+
+    m_pool_stats.created++;
+
+    return new ChunkType(position);
+}
+
+template<typename Context>
+BasicChunk<Context>* BasicChunkManager<Context>::insert_chunk(Point chunk_position, ChunkType* chunk)
+{
+    SlotPage& page = get_or_create_slot_page(chunk_position);
+    const int slot_index = get_slot_index(chunk_position);
+
+    assert(page.chunks[slot_index] == nullptr && "ChunkManager::insert_chunk chunk already exists!");
+
+    page.chunks[slot_index] = chunk;
+    page.generated[slot_index] = true;
+
+    m_metrics.add_chunk_created();
+    link_neighbours(chunk, chunk_position, true);
+
+    return m_chunks.emplace_back(chunk);
+}
+
+template<typename Context>
+BasicChunk<Context>* BasicChunkManager<Context>::get_chunk_or_create(Point chunk_position)
+{
+    // return an existing chunk
+    if (ChunkType* chunk = get_chunk(chunk_position))
+    {
+        return chunk;
+    }
+
+    // or create a new one, chunks live on the heap so pointers to the others stay valid
+    return create_chunk(chunk_position); 
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::link_neighbours(ChunkType* chunk, Point chunk_position, bool link)
+{
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            if (x == 0 && y == 0) continue;
+
+            ChunkType* neighbour = get_chunk({ chunk_position.x + x, chunk_position.y + y });
+
+            if (neighbour == nullptr) continue;
+
+            // both sides see each other, or forget each other
+            chunk->set_neighbour(x, y, link ? neighbour : nullptr);
+            neighbour->set_neighbour(-x, -y, link ? chunk : nullptr);
+        }
+    }
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::retire_chunk(ChunkType* chunk)
+{
+    // remove chunk from the world, the caller takes it out of m_chunks
+    const Point chunk_position = get_chunk_position(chunk);
+
+    link_neighbours(chunk, chunk_position, false);
+    get_slot_page(chunk_position)->chunks[get_slot_index(chunk_position)] = nullptr;
+
+    m_chunk_pool.push_back(chunk);
+    m_pool_stats.retired++;
+    m_metrics.add_chunk_destroyed();
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::clear_chunks()
+{
+    for (auto* chunk : m_chunks)
+    {
+        retire_chunk(chunk);
+    }
+
+    m_chunks.clear();
+
+    // particles are cells too
+    m_particles.clear();
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::remove_empty_chunks()
+{
+    // go through each chunk and check if its empty
+    for (auto it = m_chunks.begin(); it != m_chunks.end();)
+    {
+        ChunkType* chunk = *it;
+
+        // only retire chunks that stayed empty for a while
+        if (chunk->count_empty_step() > m_removal_grace_steps)
+        {
+            // a stored copy would bring the old cells back
+            if (m_region_store != nullptr)
+            {
+                m_region_store->erase_chunk(get_chunk_position(chunk));
+            }
+
+            retire_chunk(chunk);
+            it = m_chunks.erase(it);
+        }
+        else 
+        {
+            it++;
+        }
+    }
+}
+
+template<typename Context>
+bool BasicChunkManager<Context>::can_page_out(const ChunkType* chunk) const
+{
+    // empty chunks are left to remove_empty_chunks
+    if (chunk->should_remove() || !chunk->is_asleep()) return false;
+    if (chunk->get_asleep_steps() <= m_removal_grace_steps) return false;
+
+    // an awake neighbour could move cells into the chunk any time
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            if (x == 0 && y == 0) continue;
+
+            const ChunkType* neighbour = chunk->get_neighbour(x, y);
+
+            if (neighbour != nullptr && !neighbour->is_asleep()) return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::page_out_chunks()
+{
+    if (m_chunks.size() <= m_max_resident_chunks) return;
+
+    m_page_out_candidates.clear();
+
+    for (auto* chunk : m_chunks)
+    {
+        if (can_page_out(chunk)) m_page_out_candidates.push_back(chunk);
+    }
+
+    // the longest asleep chunks are the least likely to be needed soon
+    const size_t count = std::min(m_chunks.size() - m_max_resident_chunks, m_page_out_candidates.size());
+
+    std::partial_sort(
+        m_page_out_candidates.begin(), m_page_out_candidates.begin() + count, m_page_out_candidates.end(), 
+        [](const ChunkType* a, const ChunkType* b) { return a->get_asleep_steps() > b->get_asleep_steps(); }
+    );
+
+    size_t paged_out = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        ChunkType* chunk = m_page_out_candidates[i];
+
+        // keep the chunk if it couldnt be written
+        if (!m_region_store->save_chunk(get_chunk_position(chunk), *chunk)) continue;
+
+        retire_chunk(chunk);
+        paged_out++;
+    }
+
+    if (paged_out == 0) return;
+
+    // retired chunks no longer own their slot
+    m_chunks.erase(std::remove_if(m_chunks.begin(), m_chunks.end(), [&](const ChunkType* chunk)
+    {
+        return get_chunk(get_chunk_position(chunk)) != chunk;
+    }), m_chunks.end());
+
+    m_paging_stats.paged_out += paged_out;
+}
+
+template<typename Context>
+void BasicChunkManager<Context>::wake_up_chunk(int x, int y)
+{
+    // only wake up chunk if it exists
+    if (ChunkType* chunk = get_chunk(grid_to_chunk(x, y)))
+    {
+        chunk->wake_up(grid_to_chunk_local(x, y));
+    }
+}
+
+// the default context is built once in chunk_manager.cpp
+extern template class BasicChunkManager<ChunkContext>;
 
-    std::unordered_map<Point, Chunk*> m_chunk_lookup;
-    boost::container::static_vector<Chunk*, c_max_chunks> m_chunks;
-};
\ No newline at end of file
+using ChunkManager = BasicChunkManager<ChunkContext>;
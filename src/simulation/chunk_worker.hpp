@@ -1,30 +1,361 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
 #include "simulation/chunk.hpp"
 #include "simulation/chunk_manager.hpp"
+#include "utils/counter_random.hpp"
+#include "utils/trace.hpp"
 
-class ChunkWorker
+template<typename Context>
+class BasicChunkWorker
 {
 public:
-    ChunkWorker(ChunkManager& manager, Chunk* chunk);
-    virtual ~ChunkWorker() = default;
+    using ContextType = Context;
+    using ChunkType = BasicChunk<Context>;
+    using ManagerType = BasicChunkManager<Context>;
+
+    BasicChunkWorker(ManagerType& manager, ChunkType* chunk);
+    virtual ~BasicChunkWorker() = default;
 
     void update_chunk(float time_step);
 
+public:
+    // fastest a cell can move in a step, the manager only makes sure chunks this far away exist
+    static constexpr int c_max_speed = ManagerType::c_worker_reach;
+
 protected:
     virtual void update_cell(const Cell& cell, int x, int y) = 0;
 
-    const Cell* get_cell(int x, int y);
+    // runs before the cells of a row, y is the row in the chunk and cells the filled ones inside the rect (bit x for column x)
+    // returns the cells it already updated in bulk, update_cell is skipped for those
+    // and so is their life time while the chunk has none, they have to be of types without a default one
+    virtual uint64_t update_row(int /*y*/, uint64_t /*cells*/) { return 0; }
+
+    const ChunkType& get_chunk() const;
+    // cell coordinates of the chunk's top left
+    Point get_grid_position() const;
+
+    std::optional<Cell> get_cell(int x, int y);
     void set_cell(int x, int y, const Cell& cell);
     void move_cell(int from_x, int from_y, int to_x, int to_y);
     void push_cell(int from_x, int from_y, int dir_x, int dir_y);
     void swap_cells(int from_x, int from_y, int to_x, int to_y);
     bool is_empty(int x, int y) const;
+    CellType get_type(int x, int y) const;
+
+    // velocity of a cell in the chunk being updated
+    Point get_velocity(int x, int y) const;
+    void set_velocity(int x, int y, Point velocity);
+
+    // hands the cell over to the particles, it leaves the grid once every worker is done
+    void launch_cell(int x, int y, Point velocity);
+
+    // queues cells of row y of the chunk to move distance cells straight down, cells bit x for column x
+    // the same as setting velocity and a move_cell for each, for cells off the chunks edge that fall into empty cells
+    void drop_cells(int y, uint64_t cells, int distance, Point velocity);
+
+    // follows a line towards the target and stops in front of the first filled cell or the world edge
+    // returns the last free cell on the line, the start when the first step is blocked
+    Point trace_path(int from_x, int from_y, int to_x, int to_y) const;
+
+    // the same number for the same seed, step and cell, draw gives a cell more than one number
+    uint32_t get_random(int x, int y, uint32_t draw = 0) const;
 
 private:
-    void handle_life_time(Cell& cell, int x, int y, float time_step);
+    bool find_nearby_chunk(int x, int y, const ChunkType*& chunk, Point& local_position) const;
+    void handle_life_time(int x, int y, float time_step);
 
 private:
-    ChunkManager& m_manager;
-    Chunk* m_chunk = nullptr;
-};
\ No newline at end of file
+    ManagerType& m_manager;
+    ChunkType* m_chunk = nullptr;
+    Point m_grid_position;
+    CounterRandom m_random;
+};
+
+template<typename Context>
+BasicChunkWorker<Context>::BasicChunkWorker(ManagerType& manager, ChunkType* chunk) : m_manager(manager), m_chunk(chunk), m_random(manager.get_random())
+{
+    const Point position = m_chunk->get_position();
+
+    // cell coordinates of the chunks top left
+    m_grid_position = {
+        position.x / Context::cell_size,
+        position.y / Context::cell_size
+    };
+}
+
+template<typename Context>
+void BasicChunkWorker<Context>::update_chunk(float time_step)
+{
+    const IntRect& rect = m_chunk->get_current_rect();
+
+    // asleep
+    if (rect.min_x > rect.max_x || rect.min_y > rect.max_y) return;
+
+    TRACE_SCOPE_CHUNK("update_chunk", Point(m_grid_position.x / Context::width, m_grid_position.y / Context::height));
+
+    uint64_t visited = 0;
+
+    for (int y = rect.max_y; y >= rect.min_y; y--)
+    {
+        // only the columns of the tiles that are awake in this row
+        const uint64_t row = m_chunk->get_row_mask(y) & m_chunk->get_dirty_mask(y);
+
+        if (row == 0) continue;
+
+        const uint64_t updated = update_row(y, row);
+
+        // jump straight from one filled cell to the next
+        for (uint64_t filled = row; filled != 0; filled &= filled - 1)
+        {
+            const int x = std::countr_zero(filled);
+
+            if (!(updated & (uint64_t(1) << x)))
+            {
+                const Cell cell = m_chunk->get_cell({ x, y });
+                const Point world_position = {
+                    x + m_grid_position.x,
+                    y + m_grid_position.y
+                };
+
+                update_cell(cell, world_position.x, world_position.y);
+            }
+
+            // cells updated in bulk still age when there are life times, in the same order as the others
+            if (!(updated & (uint64_t(1) << x)) || m_chunk->has_life_times()) handle_life_time(x, y, time_step);
+        }
+
+        visited += std::popcount(row);
+    }
+
+    m_manager.get_metrics().add_cells_visited(visited);
+}
+
+template<typename Context>
+const typename BasicChunkWorker<Context>::ChunkType& BasicChunkWorker<Context>::get_chunk() const
+{
+    return *m_chunk;
+}
+
+template<typename Context>
+Point BasicChunkWorker<Context>::get_grid_position() const
+{
+    return m_grid_position;
+}
+
+template<typename Context>
+std::optional<Cell> BasicChunkWorker<Context>::get_cell(int x, int y)
+{
+    const ChunkType* chunk = nullptr;
+    Point local_position;
+
+    if (find_nearby_chunk(x, y, chunk, local_position) && chunk != nullptr)
+    {
+        return chunk->get_cell(local_position);
+    }
+
+    // let the manager sort out missing chunks and the world edge
+    return m_manager.get_cell(x, y);
+}
+
+template<typename Context>
+void BasicChunkWorker<Context>::set_cell(int x, int y, const Cell& cell)
+{
+    m_manager.set_cell(x, y, cell);
+}
+
+template<typename Context>
+void BasicChunkWorker<Context>::move_cell(int from_x, int from_y, int to_x, int to_y)
+{
+    m_manager.move_cell(from_x, from_y, to_x, to_y, false);
+}
+
+template<typename Context>
+void BasicChunkWorker<Context>::push_cell(int from_x, int from_y, int dir_x, int dir_y)
+{
+    const Point target = trace_path(from_x, from_y, from_x + dir_x, from_y + dir_y);
+
+    if (target.x != from_x || target.y != from_y)
+    {
+        move_cell(from_x, from_y, target.x, target.y);
+    }
+}
+
+template<typename Context>
+void BasicChunkWorker<Context>::swap_cells(int from_x, int from_y, int to_x, int to_y)
+{
+    m_manager.move_cell(from_x, from_y, to_x, to_y, true);
+}
+
+template<typename Context>
+bool BasicChunkWorker<Context>::is_empty(int x, int y) const
+{
+    return get_type(x, y) == CellType::Empty;
+}
+
+template<typename Context>
+CellType BasicChunkWorker<Context>::get_type(int x, int y) const
+{
+    const int local_x = x - m_grid_position.x;
+    const int local_y = y - m_grid_position.y;
+
+    // the neighbourhood is already in the halo
+    if (m_chunk->in_halo_bounds(local_x, local_y))
+    {
+        return m_chunk->get_halo_type(local_x, local_y);
+    }
+
+    const ChunkType* chunk = nullptr;
+    Point local_position;
+
+    if (find_nearby_chunk(x, y, chunk, local_position))
+    {
+        return chunk != nullptr ? chunk->get_type(local_position) : CellType::Empty;
+    }
+
+    const std::optional<Cell> cell = m_manager.get_cell(x, y);
+
+    return cell.has_value() ? cell->type : CellType::Empty;
+}
+
+template<typename Context>
+Point BasicChunkWorker<Context>::get_velocity(int x, int y) const
+{
+    const Point local_position = { x - m_grid_position.x, y - m_grid_position.y };
+
+    assert(m_chunk->in_bounds(local_position) && "ChunkWorker::get_velocity not in the chunk being updated!");
+
+    return m_chunk->get_velocity(local_position.x + local_position.y * Context::width);
+}
+
+template<typename Context>
+void BasicChunkWorker<Context>::set_velocity(int x, int y, Point velocity)
+{
+    const Point local_position = { x - m_grid_position.x, y - m_grid_position.y };
+
+    assert(m_chunk->in_bounds(local_position) && "ChunkWorker::set_velocity not in the chunk being updated!");
+
+    m_chunk->set_velocity(local_position.x + local_position.y * Context::width, velocity);
+}
+
+template<typename Context>
+void BasicChunkWorker<Context>::launch_cell(int x, int y, Point velocity)
+{
+    m_manager.launch_cell(x, y, static_cast<float>(velocity.x), static_cast<float>(velocity.y));
+}
+
+template<typename Context>
+void BasicChunkWorker<Context>::drop_cells(int y, uint64_t cells, int distance, Point velocity)
+{
+    m_chunk->drop_cells(y, cells, distance, velocity);
+}
+
+template<typename Context>
+Point BasicChunkWorker<Context>::trace_path(int from_x, int from_y, int to_x, int to_y) const
+{
+    const int delta_x = std::abs(to_x - from_x);
+    const int delta_y = -std::abs(to_y - from_y);
+    const int step_x = from_x < to_x ? 1 : -1;
+    const int step_y = from_y < to_y ? 1 : -1;
+    int error = delta_x + delta_y;
+
+    Point position = { from_x, from_y };
+    Point last_free = position;
+
+    // the chunk the line is in, only looked up again when the line crosses a chunk border
+    const ChunkType* chunk = m_chunk;
+    Point chunk_origin = m_grid_position;
+
+    while (position.x != to_x || position.y != to_y)
+    {
+        // bresenham, step along whichever axes keep closest to the line
+        const int error_2 = error * 2;
+
+        if (error_2 >= delta_y) { error += delta_y; position.x += step_x; }
+        if (error_2 <= delta_x) { error += delta_x; position.y += step_y; }
+
+        Point local_position = { position.x - chunk_origin.x, position.y - chunk_origin.y };
+
+        if (local_position.x < 0 || local_position.y < 0 || local_position.x >= Context::width || local_position.y >= Context::height)
+        {
+            // a missing chunk is air, but past the world edge is a wall
+            if (!find_nearby_chunk(position.x, position.y, chunk, local_position)) break;
+            if (chunk == nullptr && !m_manager.get_cell(position.x, position.y).has_value()) break;
+
+            chunk_origin = { position.x - local_position.x, position.y - local_position.y };
+        }
+
+        if (chunk != nullptr && !chunk->is_empty(local_position)) break;
+
+        last_free = position;
+    }
+
+    return last_free;
+}
+
+template<typename Context>
+uint32_t BasicChunkWorker<Context>::get_random(int x, int y, uint32_t draw) const
+{
+    // keyed by the chunk and the cell relative to it
+    return m_random.get(m_grid_position, (x - m_grid_position.x) + (y - m_grid_position.y) * Context::width, draw);
+}
+
+template<typename Context>
+bool BasicChunkWorker<Context>::find_nearby_chunk(int x, int y, const ChunkType*& chunk, Point& local_position) const
+{
+    constexpr int width = Context::width;
+    constexpr int height = Context::height;
+
+    local_position = { x - m_grid_position.x, y - m_grid_position.y };
+
+    // too far away for the neighbour links
+    if (local_position.x < -width || local_position.x >= width * 2 || 
+        local_position.y < -height || local_position.y >= height * 2)
+    {
+        return false;
+    }
+
+    const int offset_x = local_position.x < 0 ? -1 : (local_position.x >= width ? 1 : 0);
+    const int offset_y = local_position.y < 0 ? -1 : (local_position.y >= height ? 1 : 0);
+
+    local_position.x -= offset_x * width;
+    local_position.y -= offset_y * height;
+
+    // most lookups stay within the chunk being updated
+    chunk = (offset_x == 0 && offset_y == 0) ? m_chunk : m_chunk->get_neighbour(offset_x, offset_y);
+
+    return true;
+}
+
+template<typename Context>
+void BasicChunkWorker<Context>::handle_life_time(int x, int y, float time_step)
+{
+    const int index = x + y * Context::width;
+    float life_time = m_chunk->get_life_time(index);
+
+    if (life_time >= 0)
+    {
+        life_time -= time_step;
+
+        if (life_time <= 0)
+        {
+            m_chunk->set_cell(index, Cell());
+        }
+        else
+        {
+            m_chunk->set_life_time(index, life_time);
+            m_chunk->wake_up({ x, y });
+        }
+    }
+}
+
+// the default context is built once in chunk_worker.cpp
+extern template class BasicChunkWorker<ChunkContext>;
+
+using ChunkWorker = BasicChunkWorker<ChunkContext>;
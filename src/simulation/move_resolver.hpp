@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+// picks one change per destination in a single pass over the changes
+// the change with the highest priority wins, random priorities give every change the same chance
+// and the result doesnt depend on the order the changes were pushed in
+template<int Size>
+class MoveResolver
+{
+public:
+    template<typename Change, typename Priority, typename Apply>
+    void resolve(std::span<const Change> changes, Priority&& priority, Apply&& apply)
+    {
+        assert(changes.size() <= 0xFFFF && "MoveResolver::resolve too many changes!");
+
+        for (uint16_t i = 0; i < changes.size(); i++)
+        {
+            const int destination = changes[i].dst_index;
+            const uint64_t change_priority = priority(changes[i]);
+            uint64_t& claimed = m_claimed[destination / 64];
+            const uint64_t bit = uint64_t(1) << (destination % 64);
+
+            if (!(claimed & bit) || change_priority > m_priorities[destination])
+            {
+                claimed |= bit;
+                m_winners[destination] = i;
+                m_priorities[destination] = change_priority;
+            }
+        }
+
+        // apply in destination order, keeps swaps that touch each other deterministic
+        for (int word = 0; word < c_words; word++)
+        {
+            for (uint64_t claimed = m_claimed[word]; claimed != 0; claimed &= claimed - 1)
+            {
+                apply(changes[m_winners[word * 64 + std::countr_zero(claimed)]]);
+            }
+
+            m_claimed[word] = 0;
+        }
+    }
+
+private:
+    static constexpr int c_words = (Size + 63) / 64;
+
+private:
+    std::array<uint64_t, c_words> m_claimed = {};
+    std::array<uint16_t, Size> m_winners;
+    std::array<uint64_t, Size> m_priorities;
+};
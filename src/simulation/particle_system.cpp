@@ -0,0 +1,107 @@
+#include "simulation/particle_system.hpp"
+
+void ParticleSystem::add(const Cell& cell, float x, float y, float velocity_x, float velocity_y, float max_speed)
+{
+    m_x.push_back(x);
+    m_y.push_back(y);
+    m_velocity_x.push_back(velocity_x);
+    m_velocity_y.push_back(velocity_y);
+    m_max_speed.push_back(max_speed);
+    m_cells.push_back(cell);
+}
+
+void ParticleSystem::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_velocity_x.clear();
+    m_velocity_y.clear();
+    m_max_speed.clear();
+    m_cells.clear();
+}
+
+size_t ParticleSystem::size() const
+{
+    return m_cells.size();
+}
+
+bool ParticleSystem::empty() const
+{
+    return m_cells.empty();
+}
+
+Point ParticleSystem::get_position(size_t index) const
+{
+    return { static_cast<int>(std::floor(m_x[index])), static_cast<int>(std::floor(m_y[index])) };
+}
+
+const Cell& ParticleSystem::get_cell(size_t index) const
+{
+    return m_cells[index];
+}
+
+void ParticleSystem::serialize(ByteWriter& writer) const
+{
+    writer.write(static_cast<uint32_t>(m_cells.size()));
+
+    for (size_t i = 0; i < m_cells.size(); i++)
+    {
+        writer.write(m_x[i]);
+        writer.write(m_y[i]);
+        writer.write(m_velocity_x[i]);
+        writer.write(m_velocity_y[i]);
+        writer.write(m_max_speed[i]);
+        writer.write(m_cells[i].type);
+        writer.write(m_cells[i].colour);
+        writer.write(m_cells[i].life_time);
+    }
+}
+
+bool ParticleSystem::deserialize(ByteReader& reader)
+{
+    clear();
+
+    uint32_t count = 0;
+
+    if (!reader.read(count)) return false;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float values[5];
+        Cell cell;
+
+        if (!reader.read(values) || !reader.read(cell.type) || !reader.read(cell.colour) || !reader.read(cell.life_time))
+        {
+            clear();
+            return false;
+        }
+
+        add(cell, values[0], values[1], values[2], values[3], values[4]);
+    }
+
+    return true;
+}
+
+void ParticleSystem::remove(size_t index)
+{
+    // order doesnt matter, fill the gap with the last particle
+    const size_t last = m_cells.size() - 1;
+
+    m_x[index] = m_x[last];
+    m_y[index] = m_y[last];
+    m_velocity_x[index] = m_velocity_x[last];
+    m_velocity_y[index] = m_velocity_y[last];
+    m_max_speed[index] = m_max_speed[last];
+    m_cells[index] = m_cells[last];
+    m_next_x[index] = m_next_x[last];
+    m_next_y[index] = m_next_y[last];
+
+    m_x.pop_back();
+    m_y.pop_back();
+    m_velocity_x.pop_back();
+    m_velocity_y.pop_back();
+    m_max_speed.pop_back();
+    m_cells.pop_back();
+    m_next_x.pop_back();
+    m_next_y.pop_back();
+}
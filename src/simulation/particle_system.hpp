@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "core/cell.hpp"
+#include "utils/byte_stream.hpp"
+#include "utils/point.hpp"
+
+// cells flying through the air, kept out of the grid until they hit something
+// every value has its own array so a step integrates all particles in one tight loop
+class ParticleSystem
+{
+public:
+    // positions are in cells and velocities in cells per step
+    void add(const Cell& cell, float x, float y, float velocity_x, float velocity_y, float max_speed);
+    void clear();
+
+    size_t size() const;
+    bool empty() const;
+
+    // the cell a particle is over and what it looks like
+    Point get_position(size_t index) const;
+    const Cell& get_cell(size_t index) const;
+
+    // moves every particle a step, is_free(x, y) says if a particle can pass through a cell
+    // a particle that hits something goes back into the grid through land(x, y, cell), returns how many landed
+    // life times run out in the air like they do in the grid, those particles are dropped
+    // a particle buried by something else lands in the nearest free cell, with none near it waits in the air for one
+    template<typename IsFree, typename Land>
+    size_t update(float gravity, float time_step, IsFree is_free, Land land)
+    {
+        m_next_x.resize(m_cells.size());
+        m_next_y.resize(m_cells.size());
+
+        for (size_t i = 0; i < m_cells.size();)
+        {
+            float& life_time = m_cells[i].life_time;
+
+            if (life_time >= 0)
+            {
+                life_time -= time_step;
+
+                if (life_time <= 0)
+                {
+                    remove(i);
+                    continue;
+                }
+            }
+
+            i++;
+        }
+
+        const size_t count = m_cells.size();
+
+        // no branches, the compiler can vectorise this
+        for (size_t i = 0; i < count; i++)
+        {
+            m_velocity_x[i] = std::clamp(m_velocity_x[i], -m_max_speed[i], m_max_speed[i]);
+            m_velocity_y[i] = std::clamp(m_velocity_y[i] + gravity, -m_max_speed[i], m_max_speed[i]);
+            m_next_x[i] = m_x[i] + m_velocity_x[i];
+            m_next_y[i] = m_y[i] + m_velocity_y[i];
+        }
+
+        size_t landed = 0;
+
+        // follow each path through the grid, landed particles are swapped out so i only moves on for flying ones
+        for (size_t i = 0; i < m_cells.size();)
+        {
+            const Point from = get_position(i);
+            const Point to = { static_cast<int>(std::floor(m_next_x[i])), static_cast<int>(std::floor(m_next_y[i])) };
+
+            Point stop;
+
+            if (!find_stop(from, to, is_free, stop))
+            {
+                m_x[i] = m_next_x[i];
+                m_y[i] = m_next_y[i];
+                i++;
+
+                continue;
+            }
+
+            // something filled the cell it is in and there is no space near it, try again next step
+            if (!is_free(stop.x, stop.y))
+            {
+                m_velocity_x[i] = 0;
+                m_velocity_y[i] = 0;
+                i++;
+
+                continue;
+            }
+
+            Cell cell = m_cells[i];
+            cell.velocity = Point::zero();
+
+            land(stop.x, stop.y, cell);
+            remove(i);
+            landed++;
+        }
+
+        return landed;
+    }
+
+    void serialize(ByteWriter& writer) const;
+    bool deserialize(ByteReader& reader);
+
+private:
+    // true if something is in the way, stop is then the last free cell on the path
+    template<typename IsFree>
+    bool find_stop(Point from, Point to, IsFree& is_free, Point& stop) const
+    {
+        // something landed where the particle is, it comes to rest on top of it or in the nearest space around it
+        if (!is_free(from.x, from.y))
+        {
+            stop = from;
+
+            for (int i = 0; i < c_max_rise && !is_free(stop.x, stop.y); i++)
+            {
+                stop.y--;
+            }
+
+            if (!is_free(stop.x, stop.y)) find_space(from, is_free, stop);
+
+            return true;
+        }
+
+        // bresenham, the same walk workers use in the grid
+        const int delta_x = std::abs(to.x - from.x);
+        const int delta_y = -std::abs(to.y - from.y);
+        const int step_x = from.x < to.x ? 1 : -1;
+        const int step_y = from.y < to.y ? 1 : -1;
+        int error = delta_x + delta_y;
+
+        Point position = from;
+        stop = from;
+
+        while (position.x != to.x || position.y != to.y)
+        {
+            const int error_2 = error * 2;
+
+            if (error_2 >= delta_y) { error += delta_y; position.x += step_x; }
+            if (error_2 <= delta_x) { error += delta_x; position.y += step_y; }
+
+            if (!is_free(position.x, position.y)) return true;
+
+            stop = position;
+        }
+
+        return false;
+    }
+
+    // the first free cell in rings around from, the closest ring first, stop is left alone if there is none
+    template<typename IsFree>
+    void find_space(Point from, IsFree& is_free, Point& stop) const
+    {
+        for (int radius = 1; radius <= c_max_rise; radius++)
+        {
+            for (int y = from.y - radius; y <= from.y + radius; y++)
+            {
+                // the top and bottom rows of the ring are whole, the rows between only have their ends
+                const int step_x = (y == from.y - radius || y == from.y + radius) ? 1 : radius * 2;
+
+                for (int x = from.x - radius; x <= from.x + radius; x += step_x)
+                {
+                    if (!is_free(x, y)) continue;
+
+                    stop = { x, y };
+                    return;
+                }
+            }
+        }
+    }
+
+    void remove(size_t index);
+
+private:
+    // how far a particle looks for space when something filled its cell
+    static constexpr int c_max_rise = 8;
+
+private:
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_velocity_x;
+    std::vector<float> m_velocity_y;
+    std::vector<float> m_max_speed;
+    std::vector<Cell> m_cells;
+
+    // where the particles want to be after this step
+    std::vector<float> m_next_x;
+    std::vector<float> m_next_y;
+};
@@ -0,0 +1,300 @@
+#include "simulation/region_store.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+RegionStore::RegionStore(std::filesystem::path directory) : m_directory(std::move(directory))
+{
+}
+
+RegionStore::~RegionStore()
+{
+    close_regions();
+}
+
+bool RegionStore::has_chunk(Point chunk_position)
+{
+    return get_region(chunk_position).index[get_slot(chunk_position)].size != 0;
+}
+
+void RegionStore::erase_chunk(Point chunk_position)
+{
+    Region& region = get_region(chunk_position);
+    const int slot = get_slot(chunk_position);
+
+    if (region.index[slot].size == 0) return;
+
+    // the slot keeps its space, a later save of this chunk is written over it if it fits
+    region.index[slot].size = 0;
+
+    write_index_entry(region, slot);
+}
+
+std::vector<Point> RegionStore::get_stored_chunks()
+{
+    std::vector<Point> chunks;
+    std::error_code error;
+
+    for (const auto& file : std::filesystem::directory_iterator(m_directory, error))
+    {
+        Point region_position;
+
+        if (!parse_region_path(file.path(), region_position)) continue;
+
+        const Point first_chunk = { region_position.x * c_region_size, region_position.y * c_region_size };
+        const Region& region = get_region(first_chunk);
+
+        for (int slot = 0; slot < c_region_size * c_region_size; slot++)
+        {
+            if (region.index[slot].size == 0) continue;
+
+            chunks.push_back({ first_chunk.x + slot % c_region_size, first_chunk.y + slot / c_region_size });
+        }
+    }
+
+    return chunks;
+}
+
+void RegionStore::clear()
+{
+    close_regions();
+
+    std::error_code error;
+    std::vector<std::filesystem::path> paths;
+
+    for (const auto& file : std::filesystem::directory_iterator(m_directory, error))
+    {
+        Point region_position;
+
+        if (parse_region_path(file.path(), region_position)) paths.push_back(file.path());
+    }
+
+    for (const auto& path : paths)
+    {
+        std::filesystem::remove(path, error);
+    }
+}
+
+RegionStats RegionStore::get_stats() const
+{
+    RegionStats stats = m_stats;
+    stats.open_regions = m_regions.size();
+
+    return stats;
+}
+
+bool RegionStore::get_chunk_bytes(Point chunk_position, std::span<const uint8_t>& bytes)
+{
+    Region& region = get_region(chunk_position);
+    const IndexEntry& entry = region.index[get_slot(chunk_position)];
+
+    if (entry.size == 0) return false;
+
+    // page the chunk in through the mapping, only the touched pages are read from disk
+    // entries were checked against the file when it was opened, this also catches a mapping that came up short
+    const uint8_t* mapping = map_region(region, entry.offset + entry.size);
+
+    if (mapping == nullptr) return false;
+
+    bytes = { mapping + entry.offset, entry.size };
+
+    return true;
+}
+
+bool RegionStore::write_chunk_bytes(Point chunk_position, std::span<const uint8_t> bytes)
+{
+    Region& region = get_region(chunk_position);
+
+    if (region.foreign) return false;
+
+    if (region.file == -1 && !create_region_file(get_region_position(chunk_position), region))
+    {
+        return false;
+    }
+
+    const int slot = get_slot(chunk_position);
+    IndexEntry& entry = region.index[slot];
+
+    // reuse the old space if it fits, even after an erase, otherwise append to the end of the file
+    if (entry.capacity == 0 || bytes.size() > entry.capacity)
+    {
+        entry.offset = region.file_size;
+        entry.capacity = static_cast<uint32_t>(bytes.size());
+        region.file_size += bytes.size();
+    }
+
+    entry.size = static_cast<uint32_t>(bytes.size());
+
+    if (pwrite(region.file, bytes.data(), bytes.size(), entry.offset) != static_cast<ssize_t>(bytes.size()))
+    {
+        return false;
+    }
+
+    m_stats.saves++;
+    m_stats.bytes_written += bytes.size();
+
+    return write_index_entry(region, slot);
+}
+
+RegionStore::Region& RegionStore::get_region(Point chunk_position)
+{
+    const Point region_position = get_region_position(chunk_position);
+
+    auto [it, inserted] = m_regions.try_emplace(region_position);
+
+    if (!inserted) return *it->second;
+
+    it->second = std::make_unique<Region>();
+    Region& region = *it->second;
+
+    // a missing file is an empty region, the file is only created on the first save
+    const std::string path = get_region_path(region_position).string();
+    region.file = open(path.c_str(), O_RDWR);
+
+    if (region.file == -1) return region;
+
+    Header header;
+    const bool valid = 
+        pread(region.file, &header, sizeof(Header), 0) == sizeof(Header) &&
+        pread(region.file, region.index.data(), sizeof(Index), sizeof(Header)) == sizeof(Index) &&
+        header.magic == c_magic && header.version == c_version && header.region_size == c_region_size;
+
+    if (!valid)
+    {
+        // dont touch files we dont understand, its chunks read as missing and saving over them fails
+        close(region.file);
+        region.file = -1;
+        region.foreign = true;
+        region.index = {};
+
+        return region;
+    }
+
+    region.file_size = lseek(region.file, 0, SEEK_END);
+
+    // an entry pointing outside the file or into the index reads as a missing chunk, and its space is never written to
+    for (IndexEntry& entry : region.index)
+    {
+        if (!is_valid_entry(region, entry)) entry = {};
+    }
+
+    return region;
+}
+
+bool RegionStore::create_region_file(Point region_position, Region& region)
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+
+    // never truncate, a file that appeared since the region was opened or couldnt be opened is left alone
+    const std::string path = get_region_path(region_position).string();
+    region.file = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+
+    if (region.file == -1) return false;
+
+    const Header header;
+    region.index = {};
+    region.file_size = sizeof(Header) + sizeof(Index);
+
+    return 
+        pwrite(region.file, &header, sizeof(Header), 0) == sizeof(Header) &&
+        pwrite(region.file, region.index.data(), sizeof(Index), sizeof(Header)) == sizeof(Index);
+}
+
+bool RegionStore::write_index_entry(Region& region, int slot)
+{
+    const off_t offset = sizeof(Header) + slot * sizeof(IndexEntry);
+
+    return pwrite(region.file, &region.index[slot], sizeof(IndexEntry), offset) == sizeof(IndexEntry);
+}
+
+const uint8_t* RegionStore::map_region(Region& region, uint64_t end)
+{
+    if (region.file == -1) return nullptr;
+
+    // the file grew since it was mapped
+    if (region.mapping == nullptr || region.mapped_size < end)
+    {
+        if (region.mapping != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(region.mapping), region.mapped_size);
+            region.mapping = nullptr;
+        }
+
+        void* mapping = mmap(nullptr, region.file_size, PROT_READ, MAP_SHARED, region.file, 0);
+
+        if (mapping == MAP_FAILED) return nullptr;
+
+        region.mapping = static_cast<const uint8_t*>(mapping);
+        region.mapped_size = region.file_size;
+    }
+
+    if (region.mapped_size < end) return nullptr;
+
+    return region.mapping;
+}
+
+bool RegionStore::is_valid_entry(const Region& region, const IndexEntry& entry)
+{
+    if (entry.capacity == 0) return entry.size == 0;
+
+    return 
+        entry.size <= entry.capacity &&
+        entry.offset >= sizeof(Header) + sizeof(Index) &&
+        entry.offset <= region.file_size &&
+        entry.capacity <= region.file_size - entry.offset;
+}
+
+Point RegionStore::get_region_position(Point chunk_position) const
+{
+    // round down for negative chunks too
+    return {
+        chunk_position.x >= 0 ? chunk_position.x / c_region_size : (chunk_position.x - c_region_size + 1) / c_region_size,
+        chunk_position.y >= 0 ? chunk_position.y / c_region_size : (chunk_position.y - c_region_size + 1) / c_region_size,
+    };
+}
+
+int RegionStore::get_slot(Point chunk_position) const
+{
+    const Point region_position = get_region_position(chunk_position);
+    const Point local = {
+        chunk_position.x - region_position.x * c_region_size,
+        chunk_position.y - region_position.y * c_region_size
+    };
+
+    assert(local.x >= 0 && local.y >= 0 && local.x < c_region_size && local.y < c_region_size);
+
+    return local.x + local.y * c_region_size;
+}
+
+std::filesystem::path RegionStore::get_region_path(Point region_position) const
+{
+    return m_directory / ("r." + std::to_string(region_position.x) + "." + std::to_string(region_position.y) + ".region");
+}
+
+bool RegionStore::parse_region_path(const std::filesystem::path& path, Point& region_position)
+{
+    // r.<x>.<y>.region
+    const std::string name = path.filename().string();
+    int length = 0;
+
+    if (std::sscanf(name.c_str(), "r.%d.%d.region%n", &region_position.x, &region_position.y, &length) != 2) return false;
+
+    return length == static_cast<int>(name.size());
+}
+
+void RegionStore::close_regions()
+{
+    for (auto& [position, region] : m_regions)
+    {
+        if (region->mapping != nullptr) munmap(const_cast<uint8_t*>(region->mapping), region->mapped_size);
+        if (region->file != -1)         close(region->file);
+    }
+
+    m_regions.clear();
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/byte_stream.hpp"
+#include "utils/point.hpp"
+
+struct RegionStats
+{
+    size_t loads = 0;
+    size_t saves = 0;
+    size_t bytes_read = 0;
+    size_t bytes_written = 0;
+    size_t open_regions = 0;
+};
+
+// keeps chunks on disk, grouped into region files of c_region_size x c_region_size chunks
+// each file starts with an index of where every chunk lives, chunks are read back through a memory map
+class RegionStore
+{
+public:
+    explicit RegionStore(std::filesystem::path directory);
+    ~RegionStore();
+
+    RegionStore(const RegionStore&) = delete;
+    RegionStore& operator=(const RegionStore&) = delete;
+
+    bool has_chunk(Point chunk_position);
+    void erase_chunk(Point chunk_position);
+
+    // every chunk stored in the directory, in no particular order
+    std::vector<Point> get_stored_chunks();
+    // the chunk as save_chunk serialized it, valid until the next save
+    bool get_chunk_bytes(Point chunk_position, std::span<const uint8_t>& bytes);
+    // deletes every region file, for when the world is replaced
+    void clear();
+
+    // works with any chunk that can serialize itself, chunks of different sizes need their own directory
+    template<typename ChunkType>
+    bool load_chunk(Point chunk_position, ChunkType& chunk)
+    {
+        std::span<const uint8_t> bytes;
+
+        if (!get_chunk_bytes(chunk_position, bytes)) return false;
+
+        ByteReader reader(bytes);
+
+        if (!chunk.deserialize(reader)) return false;
+
+        m_stats.loads++;
+        m_stats.bytes_read += bytes.size();
+
+        return true;
+    }
+
+    template<typename ChunkType>
+    bool save_chunk(Point chunk_position, const ChunkType& chunk)
+    {
+        m_buffer.clear();
+        ByteWriter writer(m_buffer);
+        chunk.serialize(writer);
+
+        return write_chunk_bytes(chunk_position, m_buffer);
+    }
+
+    RegionStats get_stats() const;
+
+public:
+    static constexpr int c_region_size = 16;
+    static constexpr uint32_t c_magic = 0x47525353; // "SSRG"
+    static constexpr uint32_t c_version = 1;
+
+private:
+    struct Header
+    {
+        uint32_t magic = c_magic;
+        uint32_t version = c_version;
+        uint32_t region_size = c_region_size;
+        uint32_t reserved = 0;
+    };
+
+    struct IndexEntry
+    {
+        uint64_t offset = 0;   // kept after an erase, so the space can be reused
+        uint32_t size = 0;     // 0 when the chunk isnt stored
+        uint32_t capacity = 0; // space reserved in the file, a smaller chunk can be written in place
+    };
+
+    using Index = std::array<IndexEntry, c_region_size * c_region_size>;
+
+    struct Region
+    {
+        int file = -1;
+        bool foreign = false; // the file exists but isnt a region we understand, saves fail instead of overwriting it
+        uint64_t file_size = 0;
+        Index index = {};
+
+        const uint8_t* mapping = nullptr;
+        size_t mapped_size = 0;
+    };
+
+    bool write_chunk_bytes(Point chunk_position, std::span<const uint8_t> bytes);
+
+    Region& get_region(Point chunk_position);
+    bool create_region_file(Point region_position, Region& region);
+    bool write_index_entry(Region& region, int slot);
+    const uint8_t* map_region(Region& region, uint64_t end);
+
+    static bool is_valid_entry(const Region& region, const IndexEntry& entry);
+
+    Point get_region_position(Point chunk_position) const;
+    int get_slot(Point chunk_position) const;
+    std::filesystem::path get_region_path(Point region_position) const;
+    static bool parse_region_path(const std::filesystem::path& path, Point& region_position);
+    void close_regions();
+
+private:
+    std::filesystem::path m_directory;
+    std::unordered_map<Point, std::unique_ptr<Region>> m_regions;
+    std::vector<uint8_t> m_buffer;
+    RegionStats m_stats;
+};
@@ -0,0 +1,163 @@
+#include "simulation/simulation_metrics.hpp"
+
+#include <algorithm>
+
+void SimulationMetrics::set_enabled(bool enabled)
+{
+    if (enabled == m_enabled) return;
+
+    m_enabled = enabled;
+
+    // start from a clean window, old numbers would be stale
+    m_current = {};
+    m_cells_visited = 0;
+    m_moves_queued = 0;
+    m_moves_applied = 0;
+    m_window_next = 0;
+    m_window_count = 0;
+}
+
+void SimulationMetrics::add_phase_time(MetricPhase phase, double seconds)
+{
+    if (!m_enabled) return;
+
+    m_current.phase_seconds[static_cast<int>(phase)] += seconds;
+}
+
+void SimulationMetrics::add_cells_visited(uint64_t count)
+{
+    if (!m_enabled) return;
+
+    m_cells_visited.fetch_add(count, std::memory_order_relaxed);
+}
+
+void SimulationMetrics::add_moves(uint64_t queued, uint64_t applied)
+{
+    if (!m_enabled) return;
+
+    m_moves_queued.fetch_add(queued, std::memory_order_relaxed);
+    m_moves_applied.fetch_add(applied, std::memory_order_relaxed);
+}
+
+void SimulationMetrics::add_chunk_created()
+{
+    if (!m_enabled) return;
+
+    m_current.chunks_created++;
+}
+
+void SimulationMetrics::add_chunk_destroyed()
+{
+    if (!m_enabled) return;
+
+    m_current.chunks_destroyed++;
+}
+
+void SimulationMetrics::set_chunk_states(uint64_t awake, uint64_t asleep, uint64_t tiles_awake)
+{
+    if (!m_enabled) return;
+
+    m_current.chunks_awake = awake;
+    m_current.chunks_asleep = asleep;
+    m_current.tiles_awake = tiles_awake;
+}
+
+void SimulationMetrics::set_particles(uint64_t airborne, uint64_t landed)
+{
+    if (!m_enabled) return;
+
+    m_current.particles = airborne;
+    m_current.particles_landed = landed;
+}
+
+void SimulationMetrics::add_steps_dropped(uint64_t count)
+{
+    if (!m_enabled) return;
+
+    m_current.steps_dropped += count;
+}
+
+void SimulationMetrics::end_step()
+{
+    if (!m_enabled) return;
+
+    // the workers are done, collect what they added up
+    m_current.cells_visited = m_cells_visited.exchange(0, std::memory_order_relaxed);
+    m_current.moves_queued = m_moves_queued.exchange(0, std::memory_order_relaxed);
+    m_current.moves_dropped = m_current.moves_queued - m_moves_applied.exchange(0, std::memory_order_relaxed);
+
+    m_window[m_window_next] = m_current;
+    m_window_next = (m_window_next + 1) % c_window_size;
+    m_window_count = std::min(m_window_count + 1, c_window_size);
+
+    m_current = {};
+}
+
+const StepMetrics& SimulationMetrics::get_last_step() const
+{
+    return m_window[(m_window_next + c_window_size - 1) % c_window_size];
+}
+
+MetricsSummary SimulationMetrics::get_summary() const
+{
+    MetricsSummary summary;
+    summary.steps = m_window_count;
+
+    if (m_window_count == 0) return summary;
+
+    StepMetrics& total = summary.total;
+
+    const auto accumulate = [](StepMetrics& total, StepMetrics& peak, const StepMetrics& step)
+    {
+        for (size_t i = 0; i < step.phase_seconds.size(); i++)
+        {
+            total.phase_seconds[i] += step.phase_seconds[i];
+            peak.phase_seconds[i] = std::max(peak.phase_seconds[i], step.phase_seconds[i]);
+        }
+
+        const auto add = [](uint64_t& total, uint64_t& peak, uint64_t value)
+        {
+            total += value;
+            peak = std::max(peak, value);
+        };
+
+        add(total.cells_visited, peak.cells_visited, step.cells_visited);
+        add(total.moves_queued, peak.moves_queued, step.moves_queued);
+        add(total.moves_dropped, peak.moves_dropped, step.moves_dropped);
+        add(total.chunks_awake, peak.chunks_awake, step.chunks_awake);
+        add(total.chunks_asleep, peak.chunks_asleep, step.chunks_asleep);
+        add(total.tiles_awake, peak.tiles_awake, step.tiles_awake);
+        add(total.chunks_created, peak.chunks_created, step.chunks_created);
+        add(total.chunks_destroyed, peak.chunks_destroyed, step.chunks_destroyed);
+        add(total.particles, peak.particles, step.particles);
+        add(total.particles_landed, peak.particles_landed, step.particles_landed);
+        add(total.steps_dropped, peak.steps_dropped, step.steps_dropped);
+    };
+
+    for (int i = 0; i < m_window_count; i++)
+    {
+        accumulate(total, summary.peak, m_window[i]);
+    }
+
+    // counters are rounded down, they are meant for an overlay
+    StepMetrics& average = summary.average;
+
+    for (size_t i = 0; i < total.phase_seconds.size(); i++)
+    {
+        average.phase_seconds[i] = total.phase_seconds[i] / m_window_count;
+    }
+
+    average.cells_visited = total.cells_visited / m_window_count;
+    average.moves_queued = total.moves_queued / m_window_count;
+    average.moves_dropped = total.moves_dropped / m_window_count;
+    average.chunks_awake = total.chunks_awake / m_window_count;
+    average.chunks_asleep = total.chunks_asleep / m_window_count;
+    average.tiles_awake = total.tiles_awake / m_window_count;
+    average.chunks_created = total.chunks_created / m_window_count;
+    average.chunks_destroyed = total.chunks_destroyed / m_window_count;
+    average.particles = total.particles / m_window_count;
+    average.particles_landed = total.particles_landed / m_window_count;
+    average.steps_dropped = total.steps_dropped / m_window_count;
+
+    return summary;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+enum class MetricPhase : uint8_t
+{
+    Update = 0,   // halo refresh and the workers
+    ApplyMoves,
+    Particles,    // lifting airborne cells out of the grid and moving them
+    UpdateRect,
+    RemoveChunks, // retiring and paging chunks
+    PreDraw,      // added to the step that follows it
+    Count
+};
+
+struct StepMetrics
+{
+    std::array<double, static_cast<int>(MetricPhase::Count)> phase_seconds = {};
+
+    uint64_t cells_visited = 0;
+    uint64_t moves_queued = 0;
+    uint64_t moves_dropped = 0; // lost a conflict over the same destination
+    uint64_t chunks_awake = 0;
+    uint64_t chunks_asleep = 0;
+    uint64_t tiles_awake = 0;
+    uint64_t chunks_created = 0;
+    uint64_t chunks_destroyed = 0;
+    uint64_t particles = 0;         // airborne at the end of the step
+    uint64_t particles_landed = 0;
+    uint64_t steps_dropped = 0;     // skipped to catch up, added to the step that follows them
+
+    double get_phase_ms(MetricPhase phase) const
+    {
+        return phase_seconds[static_cast<int>(phase)] * 1000.0;
+    }
+};
+
+// totals, averages and peaks over the last steps
+struct MetricsSummary
+{
+    StepMetrics total;
+    StepMetrics average;
+    StepMetrics peak;
+    int steps = 0;
+};
+
+// per step timings and counters, nothing but a branch is paid while disabled
+// counters that workers add to are atomic, everything else belongs to the thread calling update
+class SimulationMetrics
+{
+public:
+    void set_enabled(bool enabled);
+    bool is_enabled() const { return m_enabled; }
+
+    void add_phase_time(MetricPhase phase, double seconds);
+    void add_cells_visited(uint64_t count);
+    void add_moves(uint64_t queued, uint64_t applied);
+    void add_chunk_created();
+    void add_chunk_destroyed();
+    void set_chunk_states(uint64_t awake, uint64_t asleep, uint64_t tiles_awake);
+    void set_particles(uint64_t airborne, uint64_t landed);
+    void add_steps_dropped(uint64_t count);
+
+    // closes the current step and moves it into the window
+    void end_step();
+
+    const StepMetrics& get_last_step() const;
+    MetricsSummary get_summary() const;
+
+public:
+    static constexpr int c_window_size = 120;
+
+private:
+    bool m_enabled = false;
+
+    StepMetrics m_current;
+    std::atomic<uint64_t> m_cells_visited = 0;
+    std::atomic<uint64_t> m_moves_queued = 0;
+    std::atomic<uint64_t> m_moves_applied = 0;
+
+    std::array<StepMetrics, c_window_size> m_window = {};
+    int m_window_next = 0;
+    int m_window_count = 0;
+};
+
+// times a phase from construction to destruction, doesnt touch the clock while metrics are disabled
+class ScopedPhaseTimer
+{
+public:
+    ScopedPhaseTimer(SimulationMetrics& metrics, MetricPhase phase) : m_metrics(metrics), m_phase(phase), m_timing(metrics.is_enabled())
+    {
+        if (m_timing) m_start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedPhaseTimer()
+    {
+        if (!m_timing) return;
+
+        m_metrics.add_phase_time(m_phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count());
+    }
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    SimulationMetrics& m_metrics;
+    MetricPhase m_phase;
+    bool m_timing = false;
+    std::chrono::steady_clock::time_point m_start;
+};
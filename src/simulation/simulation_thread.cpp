@@ -0,0 +1,102 @@
+#include "simulation/simulation_thread.hpp"
+
+SimulationThread::SimulationThread(ChunkManager& manager) : m_manager(manager)
+{
+    m_thread = std::thread(&SimulationThread::thread_loop, this);
+}
+
+SimulationThread::~SimulationThread()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    // the update in flight finishes first
+    m_work_condition.notify_all();
+    m_thread.join();
+}
+
+void SimulationThread::set_cell(int x, int y, const Cell& cell)
+{
+    std::lock_guard lock(m_edit_mutex);
+
+    m_edits.push_back({ { x, y }, cell });
+}
+
+void SimulationThread::wait()
+{
+    std::unique_lock lock(m_mutex);
+    m_done_condition.wait(lock, [this] { return !m_running; });
+}
+
+bool SimulationThread::is_running() const
+{
+    std::lock_guard lock(m_mutex);
+
+    return m_running;
+}
+
+WorldSnapshot& SimulationThread::get_snapshot()
+{
+    return m_snapshot;
+}
+
+const WorldSnapshot& SimulationThread::get_snapshot() const
+{
+    return m_snapshot;
+}
+
+void SimulationThread::apply_edits()
+{
+    {
+        std::lock_guard lock(m_edit_mutex);
+        std::swap(m_edits, m_applying_edits);
+    }
+
+    // in the order they were made, so a later edit of the same cell wins
+    for (const Edit& edit : m_applying_edits)
+    {
+        m_manager.set_cell(edit.position.x, edit.position.y, edit.cell);
+    }
+
+    m_applying_edits.clear();
+}
+
+void SimulationThread::start(std::function<void()> job)
+{
+    {
+        std::lock_guard lock(m_mutex);
+
+        m_job = std::move(job);
+        m_running = true;
+    }
+
+    m_work_condition.notify_one();
+}
+
+void SimulationThread::thread_loop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+
+        {
+            std::unique_lock lock(m_mutex);
+            m_work_condition.wait(lock, [this] { return m_stopping || m_running; });
+
+            if (!m_running) return;
+
+            job = std::move(m_job);
+        }
+
+        job();
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_running = false;
+        }
+
+        m_done_condition.notify_all();
+    }
+}
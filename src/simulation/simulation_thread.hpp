@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/cell.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "simulation/world_snapshot.hpp"
+#include "utils/point.hpp"
+
+// runs the manager's updates on their own thread, the caller reads a snapshot of the last step in the meantime
+// so a frame costs the slower of simulating and drawing instead of both
+class SimulationThread
+{
+public:
+    explicit SimulationThread(ChunkManager& manager);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    // safe at any time, edits are applied just before the next update starts
+    void set_cell(int x, int y, const Cell& cell);
+
+    // blocks until the running update finished, the manager can then be used directly until the next advance
+    void wait();
+    bool is_running() const;
+
+    // applies the queued edits, captures the world and starts the next update in the background
+    template<typename ChunkWorker>
+    void advance(float delta_time)
+    {
+        wait();
+        apply_edits();
+
+        m_snapshot.capture(m_manager);
+
+        start([this, delta_time] { m_manager.template update<ChunkWorker>(delta_time); });
+    }
+
+    // the world as it was when the running update started, only changes in advance
+    WorldSnapshot& get_snapshot();
+    const WorldSnapshot& get_snapshot() const;
+
+private:
+    struct Edit
+    {
+        Point position;
+        Cell cell;
+    };
+
+    void apply_edits();
+    void start(std::function<void()> job);
+    void thread_loop();
+
+private:
+    ChunkManager& m_manager;
+    WorldSnapshot m_snapshot;
+
+    std::mutex m_edit_mutex;
+    std::vector<Edit> m_edits;
+    std::vector<Edit> m_applying_edits;
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_work_condition;
+    std::condition_variable m_done_condition;
+
+    std::function<void()> m_job;
+    bool m_running = false;
+    bool m_stopping = false;
+};
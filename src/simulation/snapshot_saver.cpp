@@ -0,0 +1,129 @@
+#include "simulation/snapshot_saver.hpp"
+
+#include <fstream>
+#include <iterator>
+
+#include "utils/byte_stream.hpp"
+
+SnapshotSaver::~SnapshotSaver()
+{
+    wait();
+}
+
+bool SnapshotSaver::save(const ChunkManager& manager, const std::filesystem::path& path)
+{
+    if (manager.is_paging())
+    {
+        if (is_saving()) return false;
+
+        wait();
+
+        // the region files change as chunks are paged, so they are read before the manager moves on
+        m_buffer.clear();
+        ByteWriter writer(m_buffer);
+        manager.save_snapshot(writer);
+
+        m_saving = true;
+        m_thread = std::thread(&SnapshotSaver::write_file, this, path);
+
+        return true;
+    }
+
+    return start(manager.get_chunks(), manager.get_particles(), manager.get_accumulator(), manager.get_seed(), manager.get_step(), path);
+}
+
+bool SnapshotSaver::save(const WorldSnapshot& snapshot, const std::filesystem::path& path)
+{
+    if (!snapshot.has_whole_world()) return false;
+
+    return start(snapshot.get_chunks(), snapshot.get_particles(), snapshot.get_accumulator(), snapshot.get_seed(), snapshot.get_step(), path);
+}
+
+bool SnapshotSaver::is_saving() const
+{
+    return m_saving;
+}
+
+bool SnapshotSaver::wait()
+{
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    return m_succeeded;
+}
+
+bool SnapshotSaver::load(ChunkManager& manager, const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file) return false;
+
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ByteReader reader(bytes);
+
+    return manager.load_snapshot(reader);
+}
+
+bool SnapshotSaver::start(std::span<Chunk* const> chunks, const ParticleSystem& particles, float accumulator, uint64_t seed, uint64_t step, const std::filesystem::path& path)
+{
+    if (is_saving()) return false;
+
+    wait();
+
+    // take a consistent copy, this is the only part the simulation waits on
+    while (m_copies.size() < chunks.size())
+    {
+        m_copies.emplace_back(std::make_unique<Chunk>(Point::zero()));
+    }
+
+    m_copy_views.clear();
+
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        m_copies[i]->copy_from(*chunks[i]);
+        m_copy_views.push_back(m_copies[i].get());
+    }
+
+    m_particles = particles;
+    m_accumulator = accumulator;
+    m_seed = seed;
+    m_step = step;
+    m_saving = true;
+    m_thread = std::thread(&SnapshotSaver::write, this, path);
+
+    return true;
+}
+
+void SnapshotSaver::write(std::filesystem::path path)
+{
+    m_buffer.clear();
+
+    ByteWriter writer(m_buffer);
+    ChunkManager::write_snapshot(writer, m_copy_views, m_particles, m_accumulator, m_seed, m_step);
+
+    write_file(path);
+}
+
+void SnapshotSaver::write_file(const std::filesystem::path& path)
+{
+    // write next to the old snapshot and swap it in, a crash never leaves half a file behind
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+        m_succeeded = file.good();
+    }
+
+    if (m_succeeded)
+    {
+        std::error_code error;
+        std::filesystem::rename(temp_path, path, error);
+        m_succeeded = !error;
+    }
+
+    m_saving = false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "simulation/chunk.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "simulation/particle_system.hpp"
+#include "simulation/world_snapshot.hpp"
+
+// writes snapshots to a file on a background thread
+// the chunks are copied first, so the simulation can keep running while the copy is encoded and written
+class SnapshotSaver
+{
+public:
+    SnapshotSaver() = default;
+    ~SnapshotSaver();
+
+    SnapshotSaver(const SnapshotSaver&) = delete;
+    SnapshotSaver& operator=(const SnapshotSaver&) = delete;
+
+    // false if the last save is still running, call between updates
+    // a paging manager is encoded right away, the chunks on disk are read through its region store
+    bool save(const ChunkManager& manager, const std::filesystem::path& path);
+    // from a snapshot, the manager can keep running while this copies
+    // false for a snapshot of a paging manager, it only has the resident chunks
+    bool save(const WorldSnapshot& snapshot, const std::filesystem::path& path);
+    bool is_saving() const;
+    // blocks until the running save finished, returns if it succeeded
+    bool wait();
+
+    static bool load(ChunkManager& manager, const std::filesystem::path& path);
+
+private:
+    bool start(std::span<Chunk* const> chunks, const ParticleSystem& particles, float accumulator, uint64_t seed, uint64_t step, const std::filesystem::path& path);
+    void write(std::filesystem::path path);
+    void write_file(const std::filesystem::path& path);
+
+private:
+    std::thread m_thread;
+    std::atomic<bool> m_saving = false;
+    bool m_succeeded = true;
+
+    // kept between saves so a checkpoint doesnt allocate once it warmed up
+    std::vector<std::unique_ptr<Chunk>> m_copies;
+    std::vector<const Chunk*> m_copy_views;
+    ParticleSystem m_particles;
+    std::vector<uint8_t> m_buffer;
+    float m_accumulator = 0;
+    uint64_t m_seed = 0;
+    uint64_t m_step = 0;
+};
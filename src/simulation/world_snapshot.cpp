@@ -0,0 +1,149 @@
+#include "simulation/world_snapshot.hpp"
+
+#include <limits>
+
+void WorldSnapshot::capture(ChunkManager& manager)
+{
+    // the first capture has nothing to keep
+    const uint64_t steps = m_captures == 0 ? std::numeric_limits<uint64_t>::max() : manager.get_step() - m_step;
+
+    m_captures++;
+    m_copied_chunks = 0;
+    m_chunks.clear();
+
+    for (const Chunk* chunk : manager.get_chunks())
+    {
+        Copy& copy = m_copies[chunk->get_position()];
+
+        if (copy.chunk == nullptr)
+        {
+            copy.chunk = take_copy();
+            copy.chunk->copy_from(*chunk);
+            m_copied_chunks++;
+        }
+        else if (has_changed(chunk, steps))
+        {
+            // a reader may not have used the last changes yet
+            const IntRect unread_rect = copy.chunk->get_changed_rect();
+
+            copy.chunk->copy_from(*chunk);
+            copy.chunk->merge_changed_rect(unread_rect);
+            m_copied_chunks++;
+        }
+
+        copy.capture = m_captures;
+        m_chunks.push_back(copy.chunk.get());
+    }
+
+    // the changes are in the copies now
+    for (Chunk* chunk : manager.get_chunks())
+    {
+        chunk->clear_changed_rect();
+    }
+
+    // chunks that are gone from the manager
+    for (auto it = m_copies.begin(); it != m_copies.end();)
+    {
+        if (it->second.capture != m_captures)
+        {
+            m_pool.push_back(std::move(it->second.chunk));
+            it = m_copies.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+
+    m_particles = manager.get_particles();
+    m_accumulator = manager.get_accumulator();
+    m_whole_world = !manager.is_paging();
+    m_seed = manager.get_seed();
+    m_step = manager.get_step();
+
+    // the manager is between updates, so the reader's time can go into its metrics now
+    manager.get_metrics().add_phase_time(MetricPhase::PreDraw, m_pre_draw_seconds);
+    m_pre_draw_seconds = 0;
+
+    if (manager.get_metrics().is_enabled())
+    {
+        m_metrics_summary = manager.get_metrics().get_summary();
+    }
+}
+
+void WorldSnapshot::clear()
+{
+    for (auto& [position, copy] : m_copies)
+    {
+        m_pool.push_back(std::move(copy.chunk));
+    }
+
+    m_copies.clear();
+    m_chunks.clear();
+    m_particles.clear();
+    m_captures = 0;
+}
+
+std::span<Chunk* const> WorldSnapshot::get_chunks() const
+{
+    return m_chunks;
+}
+
+const ParticleSystem& WorldSnapshot::get_particles() const
+{
+    return m_particles;
+}
+
+bool WorldSnapshot::has_whole_world() const
+{
+    return m_whole_world;
+}
+
+float WorldSnapshot::get_accumulator() const
+{
+    return m_accumulator;
+}
+
+uint64_t WorldSnapshot::get_seed() const
+{
+    return m_seed;
+}
+
+uint64_t WorldSnapshot::get_step() const
+{
+    return m_step;
+}
+
+const MetricsSummary& WorldSnapshot::get_metrics_summary() const
+{
+    return m_metrics_summary;
+}
+
+void WorldSnapshot::add_pre_draw_time(double seconds)
+{
+    m_pre_draw_seconds += seconds;
+}
+
+size_t WorldSnapshot::get_copied_chunks() const
+{
+    return m_copied_chunks;
+}
+
+bool WorldSnapshot::has_changed(const Chunk* chunk, uint64_t steps) const
+{
+    const IntRect& changed_rect = chunk->get_changed_rect();
+
+    // every cell that is set grows the changed rect, but workers can change velocities and life times
+    // without that, so anything that was awake in one of the steps is copied as well
+    return changed_rect.min_x <= changed_rect.max_x || static_cast<uint64_t>(chunk->get_asleep_steps()) <= steps;
+}
+
+std::unique_ptr<Chunk> WorldSnapshot::take_copy()
+{
+    if (m_pool.empty()) return std::make_unique<Chunk>(Point::zero());
+
+    std::unique_ptr<Chunk> chunk = std::move(m_pool.back());
+    m_pool.pop_back();
+
+    return chunk;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "simulation/chunk.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "simulation/particle_system.hpp"
+#include "simulation/simulation_metrics.hpp"
+#include "utils/point.hpp"
+
+// a copy of the world between two steps, readers use it while the manager already works on the next step
+// a capture only copies chunks that changed since the last one, the others keep their old copy
+class WorldSnapshot
+{
+public:
+    WorldSnapshot() = default;
+
+    WorldSnapshot(const WorldSnapshot&) = delete;
+    WorldSnapshot& operator=(const WorldSnapshot&) = delete;
+
+    // call between updates, clears the changed rects of the manager's chunks, they move to the copies
+    void capture(ChunkManager& manager);
+    // the next capture copies every chunk, for when the manager was changed by something that skipped capturing
+    void clear();
+
+    // copies keep the changed rect until a reader clears it, like the chunks they came from
+    std::span<Chunk* const> get_chunks() const;
+    const ParticleSystem& get_particles() const;
+
+    // false if the manager was paging, the chunks on disk arent in the snapshot
+    bool has_whole_world() const;
+    float get_accumulator() const;
+    uint64_t get_seed() const;
+    uint64_t get_step() const;
+
+    // only filled in while the manager collects metrics
+    const MetricsSummary& get_metrics_summary() const;
+    // time a reader spent preparing to draw the snapshot, the next capture adds it to the step that follows
+    // like drawing from the manager does, the reader cant touch the manager's metrics while it updates
+    void add_pre_draw_time(double seconds);
+
+    // chunks the last capture had to copy
+    size_t get_copied_chunks() const;
+
+private:
+    bool has_changed(const Chunk* chunk, uint64_t steps) const;
+    std::unique_ptr<Chunk> take_copy();
+
+private:
+    struct Copy
+    {
+        std::unique_ptr<Chunk> chunk;
+        uint64_t capture = 0; // the last capture the chunk was still there
+    };
+
+    std::unordered_map<Point, Copy> m_copies;
+    std::vector<Chunk*> m_chunks;
+
+    // copies of removed chunks are handed out again
+    std::vector<std::unique_ptr<Chunk>> m_pool;
+
+    ParticleSystem m_particles;
+    MetricsSummary m_metrics_summary;
+    double m_pre_draw_seconds = 0;
+    float m_accumulator = 0;
+    bool m_whole_world = true;
+    uint64_t m_seed = 0;
+    uint64_t m_step = 0;
+    size_t m_copied_chunks = 0;
+    uint64_t m_captures = 0;
+};
@@ -0,0 +1,128 @@
+#include "utils/byte_classifier.hpp"
+
+#include <cassert>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void ByteClassifier::set_flags(uint8_t value, uint8_t flags)
+{
+    if (value >= c_small_size)
+    {
+        m_large_values += (flags != 0) - (m_flags[value] != 0);
+    }
+
+    m_flags[value] = flags;
+}
+
+uint8_t ByteClassifier::get_flags(uint8_t value) const
+{
+    return m_flags[value];
+}
+
+void ByteClassifier::clear()
+{
+    m_flags.fill(0);
+    m_large_values = 0;
+}
+
+uint64_t ByteClassifier::match(const uint8_t* bytes, int count, uint8_t flags) const
+{
+    assert(count >= 0 && count <= 64 && "ByteClassifier::match more than 64 bytes!");
+
+    if (!fits_vector_paths()) return match_scalar(bytes, count, flags);
+
+#if defined(__AVX2__)
+    return match_avx2(bytes, count, flags);
+#elif defined(__SSE2__)
+    return match_sse2(bytes, count, flags);
+#else
+    return match_scalar(bytes, count, flags);
+#endif
+}
+
+uint64_t ByteClassifier::match_scalar(const uint8_t* bytes, int count, uint8_t flags) const
+{
+    uint64_t mask = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        mask |= uint64_t((m_flags[bytes[i]] & flags) != 0) << i;
+    }
+
+    return mask;
+}
+
+#if defined(__SSE2__)
+uint64_t ByteClassifier::match_sse2(const uint8_t* bytes, int count, uint8_t flags) const
+{
+    // no byte shuffle in sse2, compare against every value that has the flags instead
+    uint8_t values[c_small_size];
+    int value_count = 0;
+
+    for (int value = 0; value < c_small_size; value++)
+    {
+        if (m_flags[value] & flags) values[value_count++] = static_cast<uint8_t>(value);
+    }
+
+    uint64_t mask = 0;
+    int i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+        __m128i hits = _mm_setzero_si128();
+
+        for (int v = 0; v < value_count; v++)
+        {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(row, _mm_set1_epi8(static_cast<char>(values[v]))));
+        }
+
+        mask |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(hits))) << i;
+    }
+
+    // whatever is left of the row
+    if (i < count) mask |= match_scalar(bytes + i, count - i, flags) << i;
+
+    return mask;
+}
+#endif
+
+#if defined(__AVX2__)
+uint64_t ByteClassifier::match_avx2(const uint8_t* bytes, int count, uint8_t flags) const
+{
+    // the small table fits a register, the shuffle looks up 32 bytes at once
+    const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_flags.data())));
+    const __m256i wanted = _mm256_set1_epi8(static_cast<char>(flags));
+    const __m256i high_bits = _mm256_set1_epi8(static_cast<char>(0xF0));
+    const __m256i zero = _mm256_setzero_si256();
+
+    uint64_t mask = 0;
+    int i = 0;
+
+    for (; i + 32 <= count; i += 32)
+    {
+        const __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i));
+
+        // the shuffle only looks at the low bits, values past the table have no flags
+        const __m256i small = _mm256_cmpeq_epi8(_mm256_and_si256(row, high_bits), zero);
+        const __m256i found = _mm256_and_si256(_mm256_shuffle_epi8(table, row), wanted);
+        const __m256i hits = _mm256_andnot_si256(_mm256_cmpeq_epi8(found, zero), small);
+
+        mask |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(hits))) << i;
+    }
+
+    // whatever is left of the row
+    if (i < count) mask |= match_scalar(bytes + i, count - i, flags) << i;
+
+    return mask;
+}
+#endif
+
+bool ByteClassifier::fits_vector_paths() const
+{
+    return m_large_values == 0;
+}
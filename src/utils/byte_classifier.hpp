@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// looks bytes up in a table of flags, a whole row of up to 64 bytes at a time
+// the vector paths keep the table in a register, so they only work while every flagged byte is below 16
+// anything else falls back to the scalar path, which gives the same answer
+class ByteClassifier
+{
+public:
+    void set_flags(uint8_t value, uint8_t flags);
+    uint8_t get_flags(uint8_t value) const;
+    void clear();
+
+    // bit i is set if the flags of bytes[i] share a bit with flags, count is at most 64
+    uint64_t match(const uint8_t* bytes, int count, uint8_t flags) const;
+
+    // the paths match picks from, each build only has the ones its instruction set allows
+    uint64_t match_scalar(const uint8_t* bytes, int count, uint8_t flags) const;
+#if defined(__SSE2__)
+    uint64_t match_sse2(const uint8_t* bytes, int count, uint8_t flags) const;
+#endif
+#if defined(__AVX2__)
+    uint64_t match_avx2(const uint8_t* bytes, int count, uint8_t flags) const;
+#endif
+
+    // false if a byte past the small table has flags
+    bool fits_vector_paths() const;
+
+private:
+    static constexpr int c_small_size = 16;
+
+private:
+    std::array<uint8_t, 256> m_flags = {};
+    int m_large_values = 0; // flagged values that dont fit the small table
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// raw little endian binary writing, values are copied as they are laid out in memory
+class ByteWriter
+{
+public:
+    explicit ByteWriter(std::vector<uint8_t>& buffer) : m_buffer(buffer) { }
+
+    template<typename T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "ByteWriter::write needs a trivially copyable type");
+
+        write_bytes(&value, sizeof(T));
+    }
+
+    void write_bytes(const void* data, size_t size)
+    {
+        const size_t offset = m_buffer.size();
+
+        m_buffer.resize(offset + size);
+        std::memcpy(m_buffer.data() + offset, data, size);
+    }
+
+    // overwrite a value written earlier, e.g. a size that wasnt known yet
+    template<typename T>
+    void write_at(size_t offset, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "ByteWriter::write_at needs a trivially copyable type");
+
+        std::memcpy(m_buffer.data() + offset, &value, sizeof(T));
+    }
+
+    size_t get_size() const
+    {
+        return m_buffer.size();
+    }
+
+private:
+    std::vector<uint8_t>& m_buffer;
+};
+
+// reads back what ByteWriter wrote, every read fails instead of running off the end
+class ByteReader
+{
+public:
+    explicit ByteReader(std::span<const uint8_t> data) : m_data(data) { }
+
+    template<typename T>
+    bool read(T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "ByteReader::read needs a trivially copyable type");
+
+        return read_bytes(&value, sizeof(T));
+    }
+
+    bool read_bytes(void* data, size_t size)
+    {
+        if (size > get_remaining()) return false;
+
+        std::memcpy(data, m_data.data() + m_offset, size);
+        m_offset += size;
+
+        return true;
+    }
+
+    // hands out the next bytes without copying them
+    bool read_span(size_t size, std::span<const uint8_t>& span)
+    {
+        if (size > get_remaining()) return false;
+
+        span = m_data.subspan(m_offset, size);
+        m_offset += size;
+
+        return true;
+    }
+
+    size_t get_remaining() const
+    {
+        return m_data.size() - m_offset;
+    }
+
+private:
+    std::span<const uint8_t> m_data;
+    size_t m_offset = 0;
+};
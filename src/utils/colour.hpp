@@ -9,6 +9,11 @@ struct Colour
     uint8_t b = 0;
     uint8_t a = 0;
 
+    bool operator==(Colour other) const
+    {
+        return r == other.r && g == other.g && b == other.b && a == other.a;
+    }
+
     const static Colour LightGrey;
     const static Colour Grey;
     const static Colour DarkGrey;
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include "utils/point.hpp"
+
+// random numbers as a hash of the seed, the step and the cell they are drawn for
+// there is no state to share between threads, the same inputs give the same number in any update order
+class CounterRandom
+{
+public:
+    constexpr CounterRandom(uint64_t seed = 0, uint64_t step = 0) : m_key(mix(mix(seed) + step)) { }
+
+    // draw picks a different number when a cell needs more than one
+    constexpr uint32_t get(Point chunk, int index, uint32_t draw = 0) const
+    {
+        const uint64_t position = static_cast<uint32_t>(chunk.x) | static_cast<uint64_t>(static_cast<uint32_t>(chunk.y)) << 32;
+        const uint64_t cell = static_cast<uint32_t>(index) | static_cast<uint64_t>(draw) << 32;
+
+        return static_cast<uint32_t>(mix(mix(m_key ^ position) ^ cell) >> 32);
+    }
+
+    // splitmix64 finalizer, every input bit affects every output bit
+    static constexpr uint64_t mix(uint64_t value)
+    {
+        value ^= value >> 30;
+        value *= 0xBF58476D1CE4E5B9;
+        value ^= value >> 27;
+        value *= 0x94D049BB133111EB;
+        value ^= value >> 31;
+
+        return value;
+    }
+
+private:
+    uint64_t m_key = 0;
+};
@@ -0,0 +1,92 @@
+#include "utils/thread_pool.hpp"
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    // the calling thread counts as one of the workers
+    for (size_t i = 1; i < thread_count; i++)
+    {
+        m_threads.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_work_condition.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+size_t ThreadPool::get_thread_count() const
+{
+    return m_threads.size() + 1;
+}
+
+void ThreadPool::run(size_t count, const void* task, TaskFunction function)
+{
+    {
+        std::lock_guard lock(m_mutex);
+
+        m_task = task;
+        m_function = function;
+        m_task_count = count;
+        m_next_task = 0;
+        m_busy_workers = m_threads.size();
+        m_generation++;
+    }
+
+    m_work_condition.notify_all();
+
+    run_tasks();
+
+    // wait for stragglers before the next phase can start
+    std::unique_lock lock(m_mutex);
+    m_done_condition.wait(lock, [this] { return m_busy_workers == 0; });
+
+    m_task = nullptr;
+    m_function = nullptr;
+}
+
+void ThreadPool::worker_loop()
+{
+    uint64_t seen_generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            m_work_condition.wait(lock, [&] { return m_stopping || m_generation != seen_generation; });
+
+            if (m_stopping) return;
+
+            seen_generation = m_generation;
+        }
+
+        run_tasks();
+
+        {
+            std::lock_guard lock(m_mutex);
+
+            if (--m_busy_workers == 0)
+            {
+                m_done_condition.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::run_tasks()
+{
+    // threads grab the next index until everything has been handed out
+    for (size_t i = m_next_task++; i < m_task_count; i = m_next_task++)
+    {
+        m_function(m_task, i);
+    }
+}
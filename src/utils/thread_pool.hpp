@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// persistent worker threads, parallel_for doubles as the barrier between phases
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t thread_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // includes the calling thread, which also takes tasks
+    size_t get_thread_count() const;
+
+    // runs task(i) for every i in [0, count) and returns once all of them finished
+    template<typename Task>
+    void parallel_for(size_t count, const Task& task)
+    {
+        if (count == 0) return;
+
+        // not worth waking anyone up
+        if (m_threads.empty() || count == 1)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                task(i);
+            }
+
+            return;
+        }
+
+        // the task stays on the callers stack, nothing is allocated to hand it over
+        run(count, &task, [](const void* task, size_t i) { (*static_cast<const Task*>(task))(i); });
+    }
+
+private:
+    using TaskFunction = void (*)(const void* task, size_t i);
+
+    void run(size_t count, const void* task, TaskFunction function);
+    void worker_loop();
+    void run_tasks();
+
+private:
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_work_condition;
+    std::condition_variable m_done_condition;
+
+    const void* m_task = nullptr;
+    TaskFunction m_function = nullptr;
+    size_t m_task_count = 0;
+    std::atomic<size_t> m_next_task = 0;
+
+    size_t m_busy_workers = 0;
+    uint64_t m_generation = 0;
+    bool m_stopping = false;
+};
@@ -0,0 +1,103 @@
+#include "utils/trace.hpp"
+
+#ifdef SAND_TRACING
+
+#include <fstream>
+#include <iomanip>
+
+Tracer& Tracer::get()
+{
+    static Tracer tracer;
+
+    return tracer;
+}
+
+void Tracer::record(const char* name, uint64_t start_ns, uint64_t end_ns, const Point* chunk)
+{
+    ThreadBuffer& buffer = get_thread_buffer();
+    const uint64_t written = buffer.written.load(std::memory_order_relaxed);
+
+    Event& event = buffer.events[written % ThreadBuffer::c_capacity];
+    event.name = name;
+    event.start_ns = start_ns;
+    event.duration_ns = end_ns - start_ns;
+    event.has_chunk = chunk != nullptr;
+
+    if (chunk != nullptr) event.chunk = *chunk;
+
+    // publish the event to the writer
+    buffer.written.store(written + 1, std::memory_order_release);
+}
+
+uint64_t Tracer::now_ns() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+bool Tracer::write_chrome_trace(const std::filesystem::path& path)
+{
+    std::lock_guard lock(m_mutex);
+    std::ofstream file(path);
+
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+    bool first = true;
+
+    for (const auto& buffer : m_buffers)
+    {
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t begin = written > ThreadBuffer::c_capacity ? written - ThreadBuffer::c_capacity : 0;
+
+        file << (first ? "" : ",\n") 
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_index
+             << ",\"args\":{\"name\":\"thread " << buffer->thread_index << "\"}}";
+        first = false;
+
+        for (uint64_t i = begin; i < written; i++)
+        {
+            const Event& event = buffer->events[i % ThreadBuffer::c_capacity];
+
+            // complete events, times in microseconds
+            file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_index
+                 << ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0;
+
+            if (event.has_chunk)
+            {
+                file << ",\"args\":{\"chunk_x\":" << event.chunk.x << ",\"chunk_y\":" << event.chunk.y << "}";
+            }
+
+            file << "}";
+        }
+    }
+
+    file << "\n]}\n";
+
+    return file.good();
+}
+
+void Tracer::clear()
+{
+    std::lock_guard lock(m_mutex);
+
+    for (const auto& buffer : m_buffers)
+    {
+        buffer->written.store(0, std::memory_order_release);
+    }
+}
+
+Tracer::ThreadBuffer& Tracer::get_thread_buffer()
+{
+    // buffers live as long as the tracer, a thread that exits leaves its events behind
+    thread_local ThreadBuffer* buffer = nullptr;
+
+    if (buffer == nullptr)
+    {
+        std::lock_guard lock(m_mutex);
+
+        buffer = m_buffers.emplace_back(std::make_unique<ThreadBuffer>()).get();
+        buffer->thread_index = static_cast<int>(m_buffers.size()) - 1;
+    }
+
+    return *buffer;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "utils/point.hpp"
+
+// scoped spans recorded per thread and written out as chrome trace events (chrome://tracing, ui.perfetto.dev)
+// only built with SAND_TRACING, otherwise the macros are empty and nothing is paid
+#ifdef SAND_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Tracer
+{
+public:
+    struct Event
+    {
+        const char* name = nullptr; // has to outlive the tracer, string literals
+        uint64_t start_ns = 0;
+        uint64_t duration_ns = 0;
+        Point chunk;
+        bool has_chunk = false;
+    };
+
+    // one writer, appends wrap around and overwrite the oldest events
+    struct ThreadBuffer
+    {
+        static constexpr size_t c_capacity = 1 << 16;
+
+        std::unique_ptr<Event[]> events = std::make_unique<Event[]>(c_capacity);
+        std::atomic<uint64_t> written = 0;
+        int thread_index = 0;
+    };
+
+    static Tracer& get();
+
+    void record(const char* name, uint64_t start_ns, uint64_t end_ns, const Point* chunk);
+    uint64_t now_ns() const;
+
+    // call between updates, spans still being written by other threads can be missed
+    bool write_chrome_trace(const std::filesystem::path& path);
+    void clear();
+
+private:
+    ThreadBuffer& get_thread_buffer();
+
+private:
+    std::mutex m_mutex; // only taken when a thread records for the first time and when writing
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    const std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+};
+
+class TraceScope
+{
+public:
+    TraceScope(const char* name) : m_name(name), m_start_ns(Tracer::get().now_ns()) { }
+    TraceScope(const char* name, Point chunk) : m_name(name), m_start_ns(Tracer::get().now_ns()), m_chunk(chunk), m_has_chunk(true) { }
+
+    ~TraceScope()
+    {
+        Tracer& tracer = Tracer::get();
+        tracer.record(m_name, m_start_ns, tracer.now_ns(), m_has_chunk ? &m_chunk : nullptr);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_start_ns;
+    Point m_chunk;
+    bool m_has_chunk = false;
+};
+
+#define SAND_TRACE_CONCAT_INNER(a, b) a##b
+#define SAND_TRACE_CONCAT(a, b) SAND_TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_SCOPE(name) TraceScope SAND_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_SCOPE_CHUNK(name, chunk) TraceScope SAND_TRACE_CONCAT(trace_scope_, __LINE__)(name, chunk)
+#define TRACE_WRITE(path) Tracer::get().write_chrome_trace(path)
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_SCOPE_CHUNK(name, chunk)
+#define TRACE_WRITE(path) ((void)(path)) // no value, only tracing builds can check the write
+
+#endif
@@ -0,0 +1,228 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "core/cell.hpp"
+#include "core/chunk_updater.hpp"
+#include "generation/cave_gen.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "test_worlds.hpp"
+
+namespace
+{
+    struct Region
+    {
+        std::vector<uint64_t> solid;
+        std::vector<uint64_t> sand;
+    };
+
+    Region generate(const CaveGen& caves, int min_x, int min_y, int width, int height)
+    {
+        Region region = { std::vector<uint64_t>(height), std::vector<uint64_t>(height) };
+        caves.generate(min_x, min_y, width, height, region.solid, region.sand);
+
+        return region;
+    }
+
+    bool is_set(const std::vector<uint64_t>& rows, int x, int y)
+    {
+        return (rows[y] >> x) & 1;
+    }
+
+    // the smoothing one cell at a time, on a grid big enough that its edges dont reach the middle
+    std::vector<std::vector<int>> smooth_reference(const std::vector<std::vector<int>>& grid, int steps)
+    {
+        std::vector<std::vector<int>> current = grid;
+
+        for (int step = 0; step < steps; step++)
+        {
+            std::vector<std::vector<int>> next = current;
+
+            for (size_t y = 1; y + 1 < current.size(); y++)
+            {
+                for (size_t x = 1; x + 1 < current[y].size(); x++)
+                {
+                    int count = 0;
+
+                    for (int offset_y = -1; offset_y <= 1; offset_y++)
+                    {
+                        for (int offset_x = -1; offset_x <= 1; offset_x++)
+                        {
+                            if (offset_x != 0 || offset_y != 0) count += current[y + offset_y][x + offset_x];
+                        }
+                    }
+
+                    if (count > 4)      next[y][x] = 1;
+                    else if (count < 4) next[y][x] = 0;
+                }
+            }
+
+            current = next;
+        }
+
+        return current;
+    }
+}
+
+TEST_CASE("Cave Gen Test", "[CaveGen]")
+{
+    const CaveGen caves(7);
+
+    SECTION("The same seed gives the same caves")
+    {
+        const Region first = generate(caves, 10, -40, 64, 64);
+        const Region again = generate(CaveGen(7), 10, -40, 64, 64);
+        const Region other = generate(CaveGen(8), 10, -40, 64, 64);
+
+        REQUIRE(first.solid == again.solid);
+        REQUIRE(first.sand == again.sand);
+        REQUIRE(first.solid != other.solid);
+    }
+
+    SECTION("Overlapping regions agree on every cell")
+    {
+        const Region large = generate(caves, -32, -32, 64, 64);
+        const Region small = generate(caves, -7, -19, 23, 40);
+
+        for (int y = 0; y < 40; y++)
+        {
+            for (int x = 0; x < 23; x++)
+            {
+                REQUIRE(is_set(small.solid, x, y) == is_set(large.solid, x + 25, y + 13));
+                REQUIRE(is_set(small.sand, x, y) == is_set(large.sand, x + 25, y + 13));
+            }
+        }
+    }
+
+    SECTION("Bit packed smoothing matches counting every cell")
+    {
+        constexpr int steps = 4;
+        constexpr int margin = steps + 2;
+
+        // without smoothing the rows are the noise itself
+        const Region noise = generate(CaveGen(7, 48, 0), -margin, -margin, 40 + margin * 2, 40 + margin * 2);
+        const Region smoothed = generate(CaveGen(7, 48, steps), 0, 0, 40, 40);
+
+        std::vector<std::vector<int>> grid(40 + margin * 2, std::vector<int>(40 + margin * 2));
+
+        for (size_t y = 0; y < grid.size(); y++)
+        {
+            for (size_t x = 0; x < grid[y].size(); x++)
+            {
+                grid[y][x] = is_set(noise.solid, static_cast<int>(x), static_cast<int>(y));
+            }
+        }
+
+        const std::vector<std::vector<int>> reference = smooth_reference(grid, steps);
+        int solid_cells = 0;
+
+        for (int y = 0; y < 40; y++)
+        {
+            for (int x = 0; x < 40; x++)
+            {
+                REQUIRE(is_set(smoothed.solid, x, y) == (reference[y + margin][x + margin] == 1));
+                solid_cells += is_set(smoothed.solid, x, y);
+            }
+        }
+
+        // caves, not a solid block or open air
+        REQUIRE(solid_cells > 40 * 40 / 5);
+        REQUIRE(solid_cells < 40 * 40 * 4 / 5);
+    }
+
+    SECTION("Sand lies on rock under air")
+    {
+        const Region region = generate(caves, 0, 0, 64, 64);
+        int sand_cells = 0;
+
+        for (int y = 1; y < 63; y++)
+        {
+            for (int x = 0; x < 64; x++)
+            {
+                if (!is_set(region.sand, x, y)) continue;
+
+                REQUIRE(is_set(region.solid, x, y));
+                REQUIRE_FALSE(is_set(region.solid, x, y - 1));
+                REQUIRE(is_set(region.solid, x, y + 1));
+                sand_cells++;
+            }
+        }
+
+        REQUIRE(sand_cells > 0);
+    }
+
+    SECTION("Chunks are generated once, in parallel or not")
+    {
+        ChunkManager serial;
+        ChunkManager parallel(3);
+
+        for (ChunkManager* manager : { &serial, &parallel })
+        {
+            manager->set_generator([&caves](Point chunk_position, Chunk& chunk) { caves.fill_chunk(chunk_position, chunk); });
+        }
+
+        serial.generate_chunks(ChunkContext::min_chunk_pos, ChunkContext::max_chunk_pos);
+        parallel.generate_chunks(ChunkContext::min_chunk_pos, ChunkContext::max_chunk_pos);
+
+        REQUIRE(serial.get_total_chunks() == static_cast<size_t>(ChunkContext::max_chunks));
+        REQUIRE(same_world(serial, parallel));
+
+        // cells match what the generator gives for the world position
+        const Region region = generate(caves, -128, 64, 64, 64);
+
+        for (int y = 0; y < 64; y++)
+        {
+            for (int x = 0; x < 64; x++)
+            {
+                const CellType type = serial.get_cell(x - 128, y + 64)->type;
+                const CellType expected = !is_set(region.solid, x, y) ? CellType::Empty : is_set(region.sand, x, y) ? CellType::Sand : CellType::Stone;
+
+                REQUIRE(type == expected);
+            }
+        }
+
+        // generating again leaves existing chunks alone
+        serial.set_cell(5, 5, Cell::Water);
+        serial.generate_chunks(ChunkContext::min_chunk_pos, ChunkContext::max_chunk_pos);
+
+        REQUIRE(serial.get_cell(5, 5)->type == CellType::Water);
+    }
+
+    SECTION("A chunk that was removed comes back as air")
+    {
+        ChunkManager manager;
+        manager.set_removal_grace_steps(0);
+
+        // chunks from before the generator are left as they are
+        manager.set_cell(0, 0, Cell::Stone);
+        manager.set_generator([&caves](Point chunk_position, Chunk& chunk) { caves.fill_chunk(chunk_position, chunk); });
+        manager.set_cell(100, 100, Cell::Water);
+
+        REQUIRE(manager.get_cell(0, 1)->type == CellType::Empty);
+        REQUIRE(manager.get_chunks().size() == 2);
+
+        const Region region = generate(caves, 64, 64, 64, 64);
+        REQUIRE((manager.get_cell(64, 64)->type != CellType::Empty) == is_set(region.solid, 0, 0));
+
+        // empty the generated chunk and let it be removed
+        for (int y = 64; y < 128; y++)
+        {
+            for (int x = 64; x < 128; x++)
+            {
+                manager.set_cell(x, y, Cell());
+            }
+        }
+
+        for (int i = 0; i < 3; i++)
+        {
+            manager.update<ChunkUpdater>(1.0f / 59.0f);
+        }
+
+        REQUIRE(manager.get_chunks().size() == 1);
+
+        manager.set_cell(100, 100, Cell::Water);
+
+        REQUIRE(manager.get_cell(64, 64)->type == CellType::Empty);
+    }
+}
@@ -0,0 +1,137 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/cell.hpp"
+#include "core/chunk_context.hpp"
+#include "core/chunk_updater.hpp"
+#include "simulation/chunk_manager.hpp"
+
+namespace
+{
+    using Pow2Context = BasicChunkContext<16, 8, 1, Point{ -2, -1 }, Point{ 1, 2 }>;
+    using OddContext = BasicChunkContext<10, 6, 2, Point{ -1, -1 }, Point{ 1, 1 }>;
+    // a billion chunk positions, far more than could ever be resident
+    using HugeContext = BasicChunkContext<64, 64, 4, Point{ -16384, -16384 }, Point{ 16383, 16383 }>;
+
+    static_assert(Pow2Context::pow2_width && Pow2Context::pow2_height);
+    static_assert(!OddContext::pow2_width && !OddContext::pow2_height);
+    static_assert(OddContext::max_chunks == 9);
+    static_assert(HugeContext::max_chunks == int64_t(32768) * 32768);
+
+    // the plain division everything has to agree with
+    Point reference_chunk(int x, int y, int width, int height)
+    {
+        return {
+            x >= 0 ? x / width : (x - width + 1) / width,
+            y >= 0 ? y / height : (y - height + 1) / height,
+        };
+    }
+
+    template<typename Context>
+    int count_filled(const BasicChunkManager<Context>& manager)
+    {
+        int filled = 0;
+
+        for (const auto* chunk : manager.get_chunks())
+        {
+            filled += chunk->get_filled_cells();
+        }
+
+        return filled;
+    }
+}
+
+TEST_CASE("Chunk Context Test", "[ChunkContext]")
+{
+    SECTION("Conversions match division for both kinds of context")
+    {
+        for (int y = -50; y <= 50; y++)
+        {
+            for (int x = -50; x <= 50; x++)
+            {
+                const Point pow2_chunk = Pow2Context::cell_to_chunk(x, y);
+                const Point pow2_local = Pow2Context::cell_to_local(x, y);
+                const Point odd_chunk = OddContext::cell_to_chunk(x, y);
+                const Point odd_local = OddContext::cell_to_local(x, y);
+
+                REQUIRE(pow2_chunk == reference_chunk(x, y, 16, 8));
+                REQUIRE(odd_chunk == reference_chunk(x, y, 10, 6));
+
+                // going back to the cell
+                REQUIRE(pow2_chunk.x * 16 + pow2_local.x == x);
+                REQUIRE(pow2_chunk.y * 8 + pow2_local.y == y);
+                REQUIRE(odd_chunk.x * 10 + odd_local.x == x);
+                REQUIRE(odd_chunk.y * 6 + odd_local.y == y);
+            }
+        }
+    }
+
+    SECTION("Small worlds end where their context says")
+    {
+        BasicChunkManager<OddContext> manager;
+
+        // the world covers cells -10 to 19 and -6 to 11
+        REQUIRE(manager.get_cell(-10, -6).has_value());
+        REQUIRE(manager.get_cell(19, 11).has_value());
+        REQUIRE_FALSE(manager.get_cell(-11, 0).has_value());
+        REQUIRE_FALSE(manager.get_cell(0, 12).has_value());
+
+        manager.set_cell(20, 0, Cell::Sand);
+        REQUIRE(manager.get_total_chunks() == 0);
+
+        for (int y = -6; y < 12; y++)
+        {
+            for (int x = -10; x < 20; x++)
+            {
+                manager.set_cell(x, y, Cell::Stone);
+            }
+        }
+
+        REQUIRE(manager.get_total_chunks() == static_cast<size_t>(OddContext::max_chunks));
+        REQUIRE(count_filled(manager) == 30 * 18);
+    }
+
+    SECTION("Huge worlds only keep the chunks that exist")
+    {
+        BasicChunkManager<HugeContext> manager(2);
+
+        // near opposite corners of the world
+        const Point far = { 1048476, 1048476 };
+
+        manager.set_cell(-far.x, -far.y, Cell::Sand);
+        manager.set_cell(far.x, far.y, Cell::Sand);
+
+        REQUIRE(manager.get_total_chunks() == 2);
+
+        for (int i = 0; i < 30; i++)
+        {
+            manager.update<BasicChunkUpdater<HugeContext>>(1.0f / 60.0f);
+        }
+
+        // falling cells may be in the air
+        REQUIRE(count_filled(manager) + manager.get_particles().size() == 2);
+        REQUIRE(manager.get_total_chunks() <= 4);
+        REQUIRE(manager.is_empty(-far.x, -far.y));
+        REQUIRE(manager.is_empty(far.x, far.y));
+    }
+
+    SECTION("Different contexts simulate side by side")
+    {
+        BasicChunkManager<Pow2Context> pow2_manager(2);
+        BasicChunkManager<OddContext> odd_manager;
+
+        pow2_manager.set_cell(3, -8, Cell::Sand);
+        odd_manager.set_cell(3, -6, Cell::Sand);
+
+        for (int i = 0; i < 60; i++)
+        {
+            pow2_manager.update<BasicChunkUpdater<Pow2Context>>(1.0f / 60.0f);
+            odd_manager.update<BasicChunkUpdater<OddContext>>(1.0f / 60.0f);
+        }
+
+        // both fell onto the bottom edge of their world
+        REQUIRE(pow2_manager.get_cell(3, 23)->type == CellType::Sand);
+        REQUIRE(odd_manager.get_cell(3, 11)->type == CellType::Sand);
+        REQUIRE(count_filled(pow2_manager) == 1);
+        REQUIRE(count_filled(odd_manager) == 1);
+    }
+}
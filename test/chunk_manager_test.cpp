@@ -1,5 +1,8 @@
 #include <catch2/catch_test_macros.hpp>
-#include <raylib.h>
+
+#include <chrono>
+#include <optional>
+#include <thread>
 
 #include "simulation/chunk_manager.hpp"
 #include "simulation/chunk_worker.hpp"
@@ -12,47 +15,60 @@ public:
     ChunkUpdater(ChunkManager& manager, Chunk* chunk) : ChunkWorker(manager, chunk) { }
 
 protected:
-    void update_cell(const Cell& cell, int x, int y)
+    void update_cell(const Cell& /*cell*/, int /*x*/, int /*y*/) override
     {
     }
 };
 
-void CustomLog(int msgType, const char *text, va_list args)
-{ 
-  return;
-}
+// every step takes at least a few milliseconds
+class SlowUpdater : public ChunkWorker
+{
+public:
+    SlowUpdater(ChunkManager& manager, Chunk* chunk) : ChunkWorker(manager, chunk) { }
 
-TEST_CASE("Chunk Manager Class Test", "[ChunkManager]")
+protected:
+    void update_cell(const Cell& /*cell*/, int /*x*/, int /*y*/) override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+};
+
+// moves every cell further than a worker may reach
+class FarUpdater : public ChunkWorker
 {
-    SetTraceLogCallback(CustomLog);
-    InitWindow(1280, 720, "Pixel Physics");
+public:
+    FarUpdater(ChunkManager& manager, Chunk* chunk) : ChunkWorker(manager, chunk) { }
+
+protected:
+    void update_cell(const Cell& cell, int x, int y) override
+    {
+        if (cell.type == CellType::Sand) push_cell(x, y, 100, 0);
+        if (cell.type == CellType::Water) move_cell(x, y, x, y + 100);
+    }
+};
 
+TEST_CASE("Chunk Manager Class Test", "[ChunkManager]")
+{
     ChunkManager manager;
 
     SECTION("Get cell from chunk")
     {
-        // need a unique ChunkContext for testing
+        const std::optional<Cell> cell = manager.get_cell(0, 0);
 
-        const Cell* cell = manager.get_cell(0, 0);
-
-        REQUIRE(cell != nullptr);
+        REQUIRE(cell.has_value());
         REQUIRE(cell->type == CellType::Empty);
-        REQUIRE(manager.get_total_chunks() == 1);
-
-        // add tests for out of bounds when unique context is a thing
+        REQUIRE(manager.get_total_chunks() == 0); // reading doesnt create a chunk
     }
 
     SECTION("Set cell in chunk")
     {
         manager.set_cell(0, 0, Cell::Sand);
 
-        const Cell* cell = manager.get_cell(0, 0);
+        const std::optional<Cell> cell = manager.get_cell(0, 0);
 
-        REQUIRE(cell != nullptr);
+        REQUIRE(cell.has_value());
         REQUIRE(cell->type == CellType::Sand);
         REQUIRE(manager.get_total_chunks() == 1);
-
-        // add tests for out of bounds when unique context is a thing
     }
 
     SECTION("Move cell in chunk")
@@ -61,24 +77,24 @@ TEST_CASE("Chunk Manager Class Test", "[ChunkManager]")
 
         manager.move_cell(0, 0, 20, 20);
 
-        const Cell* b_from = manager.get_cell(0, 0);
-        const Cell* b_to = manager.get_cell(20, 20);
+        const std::optional<Cell> b_from = manager.get_cell(0, 0);
+        const std::optional<Cell> b_to = manager.get_cell(20, 20);
 
-        REQUIRE(b_from != nullptr);
+        REQUIRE(b_from.has_value());
         REQUIRE(b_from->type == CellType::Sand);
-        REQUIRE(b_to != nullptr);
+        REQUIRE(b_to.has_value());
         REQUIRE(b_to->type == CellType::Empty); // hasnt moved yet
         REQUIRE(manager.get_total_chunks() == 1);
 
         for (int i = 0; i < 10; i++)
             manager.update<ChunkUpdater>(1.0f / 60.0f); // moved
 
-        const Cell* from = manager.get_cell(0, 0);
-        const Cell* to = manager.get_cell(20, 20);
+        const std::optional<Cell> from = manager.get_cell(0, 0);
+        const std::optional<Cell> to = manager.get_cell(20, 20);
 
-        REQUIRE(from != nullptr);
+        REQUIRE(from.has_value());
         REQUIRE(from->type == CellType::Empty);
-        REQUIRE(to != nullptr);
+        REQUIRE(to.has_value());
         REQUIRE(to->type == CellType::Sand);
         REQUIRE(manager.get_total_chunks() == 1);
     }
@@ -123,6 +139,71 @@ TEST_CASE("Chunk Manager Class Test", "[ChunkManager]")
         REQUIRE(manager.get_cell(6, 6)->type == CellType::Sand);
     }
 
+    SECTION("Cell outside of the world")
+    {
+        const int world_edge = (ChunkContext::max_chunk_pos.x + 1) * ChunkContext::width;
+
+        REQUIRE_FALSE(manager.get_cell(world_edge, 0).has_value());
+        REQUIRE(manager.is_empty(world_edge, 0));
+
+        manager.set_cell(world_edge, 0, Cell::Sand);
+
+        REQUIRE(manager.get_total_chunks() == 0);
+    }
+
+    SECTION("Chunks link up with their neighbours")
+    {
+        manager.set_cell(0, 0, Cell::Sand);
+        manager.set_cell(64, 64, Cell::Sand);
+        manager.set_cell(-1, 0, Cell::Sand);
+
+        const auto chunks = manager.get_chunks();
+
+        REQUIRE(chunks.size() == 3);
+        REQUIRE(chunks[0]->get_neighbour(1, 1) == chunks[1]);
+        REQUIRE(chunks[1]->get_neighbour(-1, -1) == chunks[0]);
+        REQUIRE(chunks[0]->get_neighbour(-1, 0) == chunks[2]);
+        REQUIRE(chunks[2]->get_neighbour(1, 0) == chunks[0]);
+        REQUIRE(chunks[2]->get_neighbour(1, 1) == nullptr);
+
+        // emptied chunks unlink once they are removed
+        manager.set_removal_grace_steps(0);
+        manager.set_cell(-1, 0, Cell());
+        manager.update<ChunkUpdater>(1.0f / 59.0f);
+
+        REQUIRE(manager.get_total_chunks() == 2);
+        REQUIRE(chunks[0]->get_neighbour(-1, 0) == nullptr);
+    }
+
+    SECTION("Empty chunks are retired after the grace period and reused")
+    {
+        manager.set_removal_grace_steps(5);
+        manager.set_cell(0, 0, Cell::Sand);
+        manager.set_cell(0, 0, Cell());
+
+        for (int i = 0; i < 5; i++)
+            manager.update<ChunkUpdater>(1.0f / 59.0f);
+
+        REQUIRE(manager.get_total_chunks() == 1); // still waiting
+
+        manager.update<ChunkUpdater>(1.0f / 59.0f);
+
+        REQUIRE(manager.get_total_chunks() == 0);
+        REQUIRE(manager.get_pool_stats().retired == 1);
+        REQUIRE(manager.get_pool_stats().pooled == 1);
+
+        // the retired chunk comes back fresh
+        manager.set_cell(-10, -10, Cell::Water);
+
+        const ChunkPoolStats stats = manager.get_pool_stats();
+
+        REQUIRE(stats.created == 1);
+        REQUIRE(stats.reused == 1);
+        REQUIRE(stats.pooled == 0);
+        REQUIRE(manager.get_chunks()[0]->get_filled_cells() == 1);
+        REQUIRE(manager.is_empty(0, 0));
+    }
+
     SECTION("Cell empty in chunk")
     {
         REQUIRE(manager.is_empty(0, 0) == true);
@@ -136,6 +217,113 @@ TEST_CASE("Chunk Manager Class Test", "[ChunkManager]")
     }
 
     // test grid conversions when context is unique
+}
 
-    CloseWindow();
-}
\ No newline at end of file
+TEST_CASE("Chunk Manager Parallel Update Test", "[ChunkManager]")
+{
+    ChunkManager manager(4);
+
+    REQUIRE(manager.get_thread_count() == 4);
+
+    SECTION("Move across chunk edges")
+    {
+        // a cell on each side of every chunk edge around the origin
+        manager.set_cell(-1, 10, Cell::Sand);
+        manager.set_cell(63, 10, Cell::Water);
+        manager.set_cell(10, -1, Cell::Stone);
+
+        manager.move_cell(-1, 10, 0, 10);
+        manager.move_cell(63, 10, 64, 10);
+        manager.move_cell(10, -1, 10, 0);
+
+        for (int i = 0; i < 10; i++)
+            manager.update<ChunkUpdater>(1.0f / 60.0f); // moved
+
+        REQUIRE(manager.get_cell(0, 10)->type == CellType::Sand);
+        REQUIRE(manager.get_cell(64, 10)->type == CellType::Water);
+        REQUIRE(manager.get_cell(10, 0)->type == CellType::Stone);
+
+        REQUIRE(manager.is_empty(-1, 10));
+        REQUIRE(manager.is_empty(63, 10));
+        REQUIRE(manager.is_empty(10, -1));
+    }
+
+    SECTION("Same destination keeps one cell")
+    {
+        manager.set_cell(63, 5, Cell::Sand);
+        manager.set_cell(65, 5, Cell::Sand);
+
+        manager.move_cell(63, 5, 64, 5);
+        manager.move_cell(65, 5, 64, 5);
+
+        for (int i = 0; i < 10; i++)
+            manager.update<ChunkUpdater>(1.0f / 60.0f); // moved
+
+        int total = 0;
+        for (int x = 63; x <= 65; x++)
+            total += manager.is_empty(x, 5) ? 0 : 1;
+
+        REQUIRE(manager.get_cell(64, 5)->type == CellType::Sand);
+        REQUIRE(total == 2); // the losing move is dropped and stays put
+    }
+
+    SECTION("Chunks past the worker reach are walls")
+    {
+        manager.set_cell(20, 20, Cell::Sand);
+        manager.set_cell(30, 30, Cell::Water);
+        manager.update<ChunkUpdater>(1.0f / 59.0f); // woken up
+
+        REQUIRE(manager.get_total_chunks() == 1);
+
+        manager.update<FarUpdater>(1.0f / 60.0f);
+
+        // the sand stops at the chunk edge, the water cant move at all, and no chunk was made
+        REQUIRE(manager.get_total_chunks() == 1);
+        REQUIRE(manager.get_cell(63, 20)->type == CellType::Sand);
+        REQUIRE(manager.get_cell(30, 30)->type == CellType::Water);
+        REQUIRE(manager.is_empty(20, 20));
+    }
+
+    SECTION("Slow frames only catch up so far")
+    {
+        manager.set_catch_up_limits(4, 0.0f);
+
+        // a second behind, the rest is dropped and only the part of a step left over is kept
+        manager.update<ChunkUpdater>(1.0f + 0.5f / 60.0f);
+
+        REQUIRE(manager.get_step() == 4);
+        REQUIRE(manager.get_dropped_steps() == 56);
+        REQUIRE(manager.get_accumulator() < manager.get_time_step());
+
+        manager.update<ChunkUpdater>(3.0f / 60.0f);
+
+        REQUIRE(manager.get_step() == 7);
+        REQUIRE(manager.get_dropped_steps() == 56);
+    }
+
+    SECTION("Catch up stops when it runs out of time")
+    {
+        manager.set_cell(0, 0, Cell::Sand);
+        manager.update<ChunkUpdater>(1.0f / 59.0f); // woken up
+        manager.set_catch_up_limits(100, 0.001f);
+
+        // the first step always runs, the time is checked before the next
+        manager.update<SlowUpdater>(10.5f / 60.0f);
+
+        REQUIRE(manager.get_step() == 2);
+        REQUIRE(manager.get_dropped_steps() == 9);
+    }
+
+    SECTION("The step rate is set at runtime")
+    {
+        manager.set_step_rate(30.0f);
+
+        REQUIRE(manager.get_time_step() == 1.0f / 30.0f);
+
+        for (int i = 0; i < 9; i++)
+            manager.update<ChunkUpdater>(1.0f / 60.0f);
+
+        REQUIRE(manager.get_step() == 4);
+        REQUIRE(manager.get_dropped_steps() == 0);
+    }
+}
@@ -1,21 +1,15 @@
 #include <catch2/catch_test_macros.hpp>
-#include <raylib.h>
 
+#include <cstdint>
+#include <vector>
 
 #include "core/cell.hpp"
+#include "utils/byte_stream.hpp"
 #include "utils/int_rect.hpp"
 #include "simulation/chunk.hpp"
 
-void CustomLog2(int msgType, const char *text, va_list args)
-{ 
-    return;
-}
-
 TEST_CASE("Chunk Class Test", "[Chunk]")
 {
-    SetTraceLogCallback(CustomLog2);
-    InitWindow(1280, 720, "Pixel Physics");
-
     Chunk chunk({ 0, 0 });
 
     SECTION("Chunk position")
@@ -48,6 +42,32 @@ TEST_CASE("Chunk Class Test", "[Chunk]")
         REQUIRE_FALSE(chunk.should_remove());
     }
 
+    SECTION("Cell attributes are kept per cell")
+    {
+        Cell custom = Cell::Sand;
+        custom.colour = Colour::Gold;
+        custom.velocity = { 1, 2 };
+
+        chunk.set_cell({ 1, 1 }, Cell::Sand);
+        chunk.set_cell({ 2, 2 }, custom);
+        chunk.set_cell({ 3, 3 }, Cell::Smoke);
+        chunk.set_life_time(3 + 3 * ChunkContext::width, 1.5f);
+
+        REQUIRE(chunk.get_type({ 2, 2 }) == CellType::Sand);
+        REQUIRE(chunk.get_cell({ 2, 2 }).colour == Colour::Gold);
+        REQUIRE(chunk.get_cell({ 2, 2 }).velocity == Point(1, 2));
+        REQUIRE(chunk.get_cell({ 1, 1 }).colour == Colour::Yellow);
+        REQUIRE(chunk.get_cell({ 1, 1 }).velocity == Point::zero());
+        REQUIRE(chunk.get_cell({ 1, 1 }).life_time == Cell::Sand.life_time);
+        REQUIRE(chunk.get_cell({ 3, 3 }).life_time == 1.5f);
+
+        // overwriting resets back to the defaults of the new type
+        chunk.set_cell({ 2, 2 }, Cell::Water);
+
+        REQUIRE(chunk.get_cell({ 2, 2 }).colour == Colour::SkyBlue);
+        REQUIRE(chunk.get_cell({ 2, 2 }).velocity == Point::zero());
+    }
+
     SECTION("Out of bounds") 
     {
         Point outOfBounds = { -1, -1 };
@@ -65,12 +85,92 @@ TEST_CASE("Chunk Class Test", "[Chunk]")
         REQUIRE(chunk.get_cell(0).type == CellType::Sand);
         REQUIRE(chunk.get_cell({ 1, 1 }).type == CellType::Empty);
 
-        chunk.apply_moved_cells();
+        chunk.apply_moved_cells(CounterRandom());
 
         REQUIRE(chunk.get_cell(0).type == CellType::Empty);
         REQUIRE(chunk.get_cell({ 1, 1 }).type == CellType::Sand);
     }
 
+    SECTION("Bounds cover filled cells")
+    {
+        chunk.set_cell({ 3, 10 }, Cell::Sand);
+        chunk.set_cell({ 20, 4 }, Cell::Stone);
+
+        IntRect bounds = chunk.generate_bounds();
+
+        REQUIRE(bounds.min_x == 3);
+        REQUIRE(bounds.min_y == 4);
+        REQUIRE(bounds.max_x == 20);
+        REQUIRE(bounds.max_y == 10);
+
+        REQUIRE_FALSE(chunk.is_row_empty(10));
+        REQUIRE_FALSE(chunk.is_column_empty(20));
+        REQUIRE(chunk.is_row_empty(5));
+        REQUIRE(chunk.is_column_empty(4));
+
+        // bounds shrink again once cells are removed
+        chunk.set_cell({ 20, 4 }, Cell());
+        bounds = chunk.generate_bounds();
+
+        REQUIRE(bounds.min_x == 3);
+        REQUIRE(bounds.min_y == 10);
+        REQUIRE(bounds.max_x == 3);
+        REQUIRE(bounds.max_y == 10);
+        REQUIRE(chunk.is_row_empty(4));
+
+        chunk.set_cell({ 3, 10 }, Cell());
+        bounds = chunk.generate_bounds();
+
+        REQUIRE(bounds.min_x > bounds.max_x);
+    }
+
+    SECTION("Changed rect covers set cells until cleared")
+    {
+        // everything is changed in a new chunk
+        REQUIRE(chunk.get_changed_rect().max_x == ChunkContext::width - 1);
+        REQUIRE(chunk.get_changed_rect().max_y == ChunkContext::height - 1);
+
+        chunk.clear_changed_rect();
+        chunk.set_cell({ 3, 10 }, Cell::Sand);
+        chunk.set_cell({ 20, 4 }, Cell::Stone);
+
+        const IntRect& changed = chunk.get_changed_rect();
+
+        REQUIRE(changed.min_x == 3);
+        REQUIRE(changed.min_y == 4);
+        REQUIRE(changed.max_x == 20);
+        REQUIRE(changed.max_y == 10);
+
+        chunk.clear_changed_rect();
+
+        REQUIRE(chunk.get_changed_rect().min_x > chunk.get_changed_rect().max_x);
+    }
+
+    SECTION("Halo copies the neighbours borders")
+    {
+        Chunk right({ ChunkContext::width * ChunkContext::cell_size, 0 });
+        Chunk below_right({ ChunkContext::width * ChunkContext::cell_size, ChunkContext::height * ChunkContext::cell_size });
+
+        right.set_cell({ 0, 7 }, Cell::Sand);
+        right.set_cell({ 2, 7 }, Cell::Sand); // past the halo
+        below_right.set_cell({ 1, 1 }, Cell::Water);
+
+        chunk.set_neighbour(1, 0, &right);
+        chunk.set_neighbour(1, 1, &below_right);
+        chunk.refresh_halo();
+
+        REQUIRE(chunk.get_halo_type(ChunkContext::width, 7) == CellType::Sand);
+        REQUIRE(chunk.get_halo_type(ChunkContext::width + 1, 7) == CellType::Empty);
+        REQUIRE(chunk.get_halo_type(ChunkContext::width + 1, ChunkContext::height + 1) == CellType::Water);
+        REQUIRE(chunk.get_halo_type(-1, 7) == CellType::Empty); // no neighbour on the left
+        REQUIRE_FALSE(chunk.in_halo_bounds(ChunkContext::width + ChunkContext::halo, 7));
+
+        // the inside of the halo is the chunk itself
+        chunk.set_cell({ 4, 4 }, Cell::Stone);
+
+        REQUIRE(chunk.get_halo_type(4, 4) == CellType::Stone);
+    }
+
     SECTION("Wake up a region updates intermediate rect") 
     {
         Point pos = { 5, 5 };
@@ -85,5 +185,68 @@ TEST_CASE("Chunk Class Test", "[Chunk]")
         REQUIRE(rect.max_y >= 5);
     }
 
-    CloseWindow();
+    SECTION("Wake ups far apart only keep their tiles awake")
+    {
+        chunk.wake_up({ 1, 1 });
+        chunk.wake_up({ 62, 62 });
+        chunk.update_rect();
+
+        REQUIRE(chunk.get_awake_tiles() == ((uint64_t(1) << 0) | (uint64_t(1) << 15)));
+        REQUIRE(chunk.get_tile_rect(0).max_x == 3);
+        REQUIRE(chunk.get_tile_rect(15).min_y == 60);
+
+        // the columns of the rows in between are left out
+        REQUIRE(chunk.get_dirty_mask(1) == 0b1111);
+        REQUIRE(chunk.get_dirty_mask(32) == 0);
+        REQUIRE(chunk.get_dirty_mask(62) == (uint64_t(0b1111) << 60));
+
+        // the whole chunk rect still covers both
+        REQUIRE(chunk.get_current_rect().min_x == 0);
+        REQUIRE(chunk.get_current_rect().max_x == 63);
+
+        // a wake up on a tile edge reaches into the tile next to it
+        chunk.wake_up({ 16, 5 });
+        chunk.update_rect();
+
+        REQUIRE(chunk.get_awake_tiles() == 0b11);
+        REQUIRE(chunk.get_dirty_mask(5) == (uint64_t(0b11111) << 14));
+
+        chunk.update_rect();
+
+        REQUIRE(chunk.get_awake_tiles() == 0);
+        REQUIRE(chunk.get_dirty_mask(5) == 0);
+    }
+
+    SECTION("Tiles are saved with the chunk")
+    {
+        chunk.set_cell({ 40, 8 }, Cell::Sand);
+        chunk.update_rect();
+        chunk.wake_up({ 3, 60 });
+
+        std::vector<uint8_t> buffer;
+        ByteWriter writer(buffer);
+        chunk.serialize(writer);
+
+        Chunk loaded({ 0, 0 });
+        ByteReader reader(buffer);
+
+        REQUIRE(loaded.deserialize(reader));
+        REQUIRE(loaded.get_awake_tiles() == chunk.get_awake_tiles());
+        REQUIRE(loaded.get_dirty_mask(8) == chunk.get_dirty_mask(8));
+
+        // the wake up that was still pending comes back too
+        loaded.update_rect();
+        chunk.update_rect();
+
+        REQUIRE(loaded.get_awake_tiles() == chunk.get_awake_tiles());
+        REQUIRE(loaded.get_dirty_mask(60) == chunk.get_dirty_mask(60));
+
+        // a tile rect reaching past its tile is refused
+        buffer[12] = 50; // max_x of the first tile
+
+        Chunk broken({ 0, 0 });
+        ByteReader broken_reader(buffer);
+
+        REQUIRE_FALSE(broken.deserialize(broken_reader));
+    }
 }
\ No newline at end of file
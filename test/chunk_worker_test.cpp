@@ -0,0 +1,148 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "simulation/chunk_manager.hpp"
+#include "simulation/chunk_worker.hpp"
+#include "core/cell.hpp"
+#include "core/chunk_updater.hpp"
+
+namespace
+{
+    std::vector<Point> s_visited;
+
+    class VisitWorker : public ChunkWorker
+    {
+    public:
+        VisitWorker(ChunkManager& manager, Chunk* chunk) : ChunkWorker(manager, chunk) { }
+
+    protected:
+        void update_cell(const Cell& /*cell*/, int x, int y) override
+        {
+            s_visited.push_back({ x, y });
+        }
+    };
+
+    Point s_path_offset;
+    std::vector<Point> s_path_ends;
+
+    // traces a path from every cell without moving anything
+    class PathWorker : public ChunkWorker
+    {
+    public:
+        PathWorker(ChunkManager& manager, Chunk* chunk) : ChunkWorker(manager, chunk) { }
+
+    protected:
+        void update_cell(const Cell& /*cell*/, int x, int y) override
+        {
+            s_path_ends.push_back(trace_path(x, y, x + s_path_offset.x, y + s_path_offset.y));
+        }
+    };
+}
+
+TEST_CASE("Chunk Worker Class Test", "[ChunkWorker]")
+{
+    ChunkManager manager;
+    s_visited.clear();
+
+    SECTION("Only filled cells are visited")
+    {
+        // a thin stream through a big dirty rect
+        for (int y = 0; y < 60; y += 6)
+        {
+            manager.set_cell(30, y, Cell::Sand);
+        }
+
+        manager.set_cell(1, 1, Cell::Stone);
+        manager.set_cell(62, 62, Cell::Stone);
+
+        // the dirty rect picks up the changes after one step
+        manager.update<VisitWorker>(1.0f / 59.0f);
+        s_visited.clear();
+        manager.update<VisitWorker>(1.0f / 59.0f);
+
+        REQUIRE(s_visited.size() == 12);
+    }
+
+    SECTION("Rows are visited from the bottom up")
+    {
+        manager.set_cell(5, 3, Cell::Sand);
+        manager.set_cell(7, 9, Cell::Sand);
+        manager.set_cell(2, 9, Cell::Sand);
+
+        // the dirty rect picks up the changes after one step
+        manager.update<VisitWorker>(1.0f / 59.0f);
+        s_visited.clear();
+        manager.update<VisitWorker>(1.0f / 59.0f);
+
+        REQUIRE(s_visited.size() == 3);
+        REQUIRE(s_visited[0] == Point(2, 9));
+        REQUIRE(s_visited[1] == Point(7, 9));
+        REQUIRE(s_visited[2] == Point(5, 3));
+    }
+
+    SECTION("Paths stop in front of filled cells and the world edge")
+    {
+        manager.set_cell(5, 10, Cell::Sand);
+        manager.set_cell(5, 20, Cell::Stone);
+        manager.set_cell(40, 50, Cell::Sand);
+        manager.set_cell(-70, 180, Cell::Sand);
+
+        // paths go down, the stone only stops the first one
+        s_path_offset = { 0, 20 };
+        s_path_ends.clear();
+
+        manager.update<PathWorker>(1.0f / 59.0f);
+        s_path_ends.clear();
+        manager.update<PathWorker>(1.0f / 59.0f);
+
+        REQUIRE(s_path_ends.size() == 4); // the stone traces a path too
+        REQUIRE(std::find(s_path_ends.begin(), s_path_ends.end(), Point(5, 19)) != s_path_ends.end());
+        REQUIRE(std::find(s_path_ends.begin(), s_path_ends.end(), Point(40, 70)) != s_path_ends.end()); // into the next chunk
+        REQUIRE(std::find(s_path_ends.begin(), s_path_ends.end(), Point(-70, 191)) != s_path_ends.end());
+
+        // a diagonal path crossing into the chunk to the left
+        manager.set_cell(2, 30, Cell::Sand);
+        s_path_offset = { -8, 8 };
+
+        manager.update<PathWorker>(1.0f / 59.0f);
+        s_path_ends.clear();
+        manager.update<PathWorker>(1.0f / 59.0f);
+
+        REQUIRE(std::find(s_path_ends.begin(), s_path_ends.end(), Point(-6, 38)) != s_path_ends.end());
+    }
+
+    SECTION("Falling cells speed up")
+    {
+        manager.set_cell(0, -120, Cell::Sand);
+
+        // nothing moves in the step that wakes the chunk up
+        manager.update<ChunkUpdater>(1.0f / 59.0f);
+
+        for (int i = 0; i < 4; i++)
+        {
+            manager.update<ChunkUpdater>(1.0f / 59.0f);
+        }
+
+        // 1 + 2 + 3 + 4 cells, fast enough to fly as a particle
+        REQUIRE(manager.get_cell(0, -110)->type == CellType::Empty);
+        REQUIRE(manager.get_particles().size() == 1);
+        REQUIRE(manager.get_particles().get_position(0) == Point(0, -110));
+
+        // lands back in the grid and stops dead on the floor
+        for (int x = -2; x <= 2; x++)
+        {
+            manager.set_cell(x, -80, Cell::Stone);
+        }
+
+        for (int i = 0; i < 10; i++)
+        {
+            manager.update<ChunkUpdater>(1.0f / 59.0f);
+        }
+
+        REQUIRE(manager.get_cell(0, -81)->type == CellType::Sand);
+        REQUIRE(manager.get_cell(0, -81)->velocity == Point::zero());
+        REQUIRE(manager.get_particles().empty());
+    }
+}
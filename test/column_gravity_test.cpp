@@ -0,0 +1,195 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "core/cell.hpp"
+#include "core/chunk_updater.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "utils/byte_classifier.hpp"
+#include "utils/counter_random.hpp"
+#include "test_worlds.hpp"
+
+namespace
+{
+    // the per cell rules only, every fall goes through the move queue
+    class ScalarUpdater : public ChunkUpdater
+    {
+    public:
+        ScalarUpdater(ChunkManager& manager, Chunk* chunk) : ChunkUpdater(manager, chunk) { }
+
+    protected:
+        uint64_t update_row(int /*y*/, uint64_t /*cells*/) override
+        {
+            return 0;
+        }
+    };
+
+    // counts the cells the rows took care of, to know the bulk path ran
+    class CountingUpdater : public ChunkUpdater
+    {
+    public:
+        CountingUpdater(ChunkManager& manager, Chunk* chunk) : ChunkUpdater(manager, chunk) { }
+
+        static inline std::atomic<size_t> s_bulk_cells = 0;
+
+    protected:
+        uint64_t update_row(int y, uint64_t cells) override
+        {
+            const uint64_t updated = ChunkUpdater::update_row(y, cells);
+            s_bulk_cells += std::popcount(updated);
+
+            return updated;
+        }
+    };
+
+    // cells of a type in the grid and in the air
+    size_t count_type(const ChunkManager& manager, CellType type)
+    {
+        size_t count = 0;
+
+        for (const Chunk* chunk : manager.get_chunks())
+        {
+            for (int i = 0; i < ChunkContext::width * ChunkContext::height; i++)
+            {
+                if (chunk->get_type(i) == type) count++;
+            }
+        }
+
+        for (size_t i = 0; i < manager.get_particles().size(); i++)
+        {
+            if (manager.get_particles().get_cell(i).type == type) count++;
+        }
+
+        return count;
+    }
+}
+
+TEST_CASE("Column Gravity Test", "[ColumnGravity]")
+{
+    SECTION("Every classifier path matches the scalar one")
+    {
+        ByteClassifier classifier;
+        classifier.set_flags(1, 0b001);
+        classifier.set_flags(4, 0b011);
+        classifier.set_flags(6, 0b100);
+        classifier.set_flags(15, 0b110);
+
+        const CounterRandom random(3);
+        std::vector<uint8_t> bytes(64);
+
+        for (int round = 0; round < 200; round++)
+        {
+            for (int i = 0; i < 64; i++)
+            {
+                // mostly small values, some past the table
+                const uint32_t value = random.get({ round, i }, 0);
+                bytes[i] = static_cast<uint8_t>(value % 4 == 0 ? value >> 8 : value % 16);
+            }
+
+            const int count = round % 65;
+
+            for (const uint8_t flags : { 0b001, 0b010, 0b100, 0b111 })
+            {
+                const uint64_t expected = classifier.match_scalar(bytes.data(), count, static_cast<uint8_t>(flags));
+
+                REQUIRE(classifier.match(bytes.data(), count, static_cast<uint8_t>(flags)) == expected);
+#if defined(__SSE2__)
+                REQUIRE(classifier.match_sse2(bytes.data(), count, static_cast<uint8_t>(flags)) == expected);
+#endif
+#if defined(__AVX2__)
+                REQUIRE(classifier.match_avx2(bytes.data(), count, static_cast<uint8_t>(flags)) == expected);
+#endif
+            }
+        }
+
+        // a flagged value past the small table sends everything down the scalar path
+        REQUIRE(classifier.fits_vector_paths());
+        classifier.set_flags(200, 0b001);
+        REQUIRE_FALSE(classifier.fits_vector_paths());
+        REQUIRE(classifier.match(bytes.data(), 64, 0b001) == classifier.match_scalar(bytes.data(), 64, 0b001));
+        classifier.set_flags(200, 0);
+        REQUIRE(classifier.fits_vector_paths());
+    }
+
+    SECTION("The fall table follows the materials")
+    {
+        const ByteClassifier& table = MaterialRegistry::get().get_fall_table();
+
+        REQUIRE(table.fits_vector_paths());
+        REQUIRE(table.get_flags(static_cast<uint8_t>(CellType::Sand)) == (MaterialRegistry::c_falls_as_powder | MaterialRegistry::c_blocks_falling));
+        REQUIRE(table.get_flags(static_cast<uint8_t>(CellType::Water)) == MaterialRegistry::c_falls_as_liquid); // sand sinks through it
+        REQUIRE(table.get_flags(static_cast<uint8_t>(CellType::Stone)) == MaterialRegistry::c_blocks_falling);
+        REQUIRE(table.get_flags(static_cast<uint8_t>(CellType::Empty)) == 0);
+
+        // a drop cant carry a life time, so sand that ages falls a cell at a time
+        MaterialRegistry registry;
+        Material sand = registry.get_material(CellType::Sand);
+        sand.life_time = 2.0f;
+        registry.set_material(CellType::Sand, sand);
+
+        REQUIRE(registry.get_fall_table().get_flags(static_cast<uint8_t>(CellType::Sand)) == MaterialRegistry::c_blocks_falling);
+    }
+
+    SECTION("Bulk and per cell updates give the same world")
+    {
+        for (const size_t threads : { 1, 3 })
+        {
+            for (const bool mixed : { false, true })
+            {
+                ChunkManager bulk(threads);
+                ChunkManager scalar(threads);
+
+                if (mixed)
+                {
+                    fill_mixed(bulk, 7);
+                    fill_mixed(scalar, 7);
+                }
+                else
+                {
+                    fill_pour(bulk);
+                    fill_pour(scalar);
+                }
+
+                CountingUpdater::s_bulk_cells = 0;
+
+                for (int i = 0; i < 240; i++)
+                {
+                    bulk.update<CountingUpdater>(1.0f / 59.0f);
+                    scalar.update<ScalarUpdater>(1.0f / 59.0f);
+
+                    if (i % 40 == 0) REQUIRE(same_world(bulk, scalar));
+                }
+
+                REQUIRE(same_world(bulk, scalar));
+                REQUIRE(CountingUpdater::s_bulk_cells > 0);
+            }
+        }
+    }
+
+    SECTION("Bulk updates keep every cell for any thread count")
+    {
+        ChunkManager serial;
+        ChunkManager parallel(3);
+
+        fill_pour(serial);
+        fill_pour(parallel);
+
+        const size_t sand = count_type(serial, CellType::Sand);
+        const size_t water = count_type(serial, CellType::Water);
+
+        for (int i = 0; i < 240; i++)
+        {
+            serial.update<ChunkUpdater>(1.0f / 59.0f);
+            parallel.update<ChunkUpdater>(1.0f / 59.0f);
+
+            if (i % 40 == 0) REQUIRE(same_world(serial, parallel));
+        }
+
+        REQUIRE(same_world(serial, parallel));
+        REQUIRE(count_type(serial, CellType::Sand) == sand);
+        REQUIRE(count_type(serial, CellType::Water) == water);
+    }
+}
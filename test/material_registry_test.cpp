@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sstream>
+#include <string>
+
+#include "core/cell.hpp"
+#include "core/material_registry.hpp"
+
+TEST_CASE("Material Registry Class Test", "[MaterialRegistry]")
+{
+    MaterialRegistry registry;
+
+    SECTION("Built in materials match the cell constants")
+    {
+        REQUIRE(registry.get_material(CellType::Sand).movement == MovementClass::Powder);
+        REQUIRE(registry.get_material(CellType::Water).movement == MovementClass::Liquid);
+        REQUIRE(registry.get_material(CellType::Smoke).movement == MovementClass::Gas);
+        REQUIRE(registry.get_material(CellType::Stone).movement == MovementClass::Solid);
+
+        REQUIRE(registry.get_default(CellType::Sand).colour == Cell::Sand.colour);
+        REQUIRE(registry.get_default(CellType::Smoke).life_time == Cell::Smoke.life_time);
+        REQUIRE(registry.find("water") == CellType::Water);
+        REQUIRE_FALSE(registry.find("lava").has_value());
+    }
+
+    SECTION("Displacement follows density")
+    {
+        REQUIRE(registry.can_displace(CellType::Sand, CellType::Empty));
+        REQUIRE(registry.can_displace(CellType::Sand, CellType::Water));
+        REQUIRE(registry.can_displace(CellType::Water, CellType::Smoke));
+        REQUIRE(registry.can_displace(CellType::Smoke, CellType::Water)); // rises through it
+
+        REQUIRE_FALSE(registry.can_displace(CellType::Water, CellType::Sand));
+        REQUIRE_FALSE(registry.can_displace(CellType::Sand, CellType::Stone));
+        REQUIRE_FALSE(registry.can_displace(CellType::Stone, CellType::Water)); // solids never move
+        REQUIRE_FALSE(registry.can_displace(CellType::Water, CellType::Water));
+    }
+
+    SECTION("Config changes and adds materials")
+    {
+        std::istringstream config(
+            "# a comment\n"
+            "[water]\n"
+            "dispersion = 4\n"
+            "max_speed = 3\n"
+            "colour = 10 20 30\n"
+            "\n"
+            "[oil]\n"
+            "movement = liquid   # lighter than water\n"
+            "density = 0.8\n"
+            "colour = 60 40 20 255\n"
+            "colour_max = 80 60 40\n"
+        );
+
+        std::string error;
+        REQUIRE(registry.load(config, &error));
+
+        const std::optional<CellType> oil = registry.find("oil");
+
+        REQUIRE(oil.has_value());
+        REQUIRE(registry.get_material(CellType::Water).dispersion == 4);
+        REQUIRE(registry.get_material(CellType::Water).max_speed == 3);
+        REQUIRE(registry.get_default(CellType::Water).colour == Colour(10, 20, 30, 255));
+        REQUIRE(registry.can_displace(CellType::Water, *oil));
+        REQUIRE(registry.can_displace(CellType::Sand, *oil));
+        REQUIRE_FALSE(registry.can_displace(*oil, CellType::Water));
+
+        // colours stay inside the range
+        REQUIRE(registry.make_cell(*oil, 0).colour == Colour(60, 40, 20, 255));
+        REQUIRE(registry.make_cell(*oil, 255).colour == Colour(80, 60, 40, 255));
+        REQUIRE(registry.make_cell(*oil, 128).colour.r > 60);
+    }
+
+    SECTION("Broken configs change nothing")
+    {
+        std::istringstream config(
+            "[water]\n"
+            "density = 5\n"
+            "[sand]\n"
+            "speed = 3\n"
+        );
+
+        std::string error;
+
+        REQUIRE_FALSE(registry.load(config, &error));
+        REQUIRE(error == "line 4: unknown key speed");
+        REQUIRE(registry.get_material(CellType::Water).density == 1.0f);
+
+        std::istringstream bad_dispersion("[water]\ndispersion = 20\n");
+        REQUIRE_FALSE(registry.load(bad_dispersion, &error));
+
+        std::istringstream bad_speed("[sand]\nmax_speed = 0\n");
+        REQUIRE_FALSE(registry.load(bad_speed, &error));
+    }
+}
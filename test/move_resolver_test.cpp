@@ -0,0 +1,111 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include "simulation/move_resolver.hpp"
+
+namespace
+{
+    struct TestChange
+    {
+        int src_index = 0;
+        int dst_index = 0;
+    };
+}
+
+TEST_CASE("Move Resolver Class Test", "[MoveResolver]")
+{
+    MoveResolver<64> resolver;
+    std::mt19937 random(1234);
+
+    const auto random_priority = [&](const TestChange&) { return static_cast<uint64_t>(random()); };
+
+    SECTION("One change per destination")
+    {
+        std::vector<TestChange> changes = {
+            { 0, 10 }, { 1, 11 }, { 2, 10 }, { 3, 12 }, { 4, 10 }, { 5, 11 }
+        };
+
+        std::array<int, 64> applied = {};
+
+        resolver.resolve(std::span<const TestChange>(changes), random_priority, [&](const TestChange& change)
+        {
+            applied[change.dst_index]++;
+        });
+
+        REQUIRE(applied[10] == 1);
+        REQUIRE(applied[11] == 1);
+        REQUIRE(applied[12] == 1);
+    }
+
+    SECTION("Every candidate has the same chance")
+    {
+        std::vector<TestChange> changes = { { 0, 7 }, { 1, 7 }, { 2, 7 }, { 3, 7 } };
+        std::array<int, 4> wins = {};
+
+        const int trials = 40000;
+
+        for (int i = 0; i < trials; i++)
+        {
+            resolver.resolve(std::span<const TestChange>(changes), random_priority, [&](const TestChange& change)
+            {
+                wins[change.src_index]++;
+            });
+        }
+
+        // expected 10000 each, allow a generous margin
+        for (int win : wins)
+        {
+            REQUIRE(win > 9400);
+            REQUIRE(win < 10600);
+        }
+    }
+
+    SECTION("Winners dont depend on the order of the changes")
+    {
+        std::vector<TestChange> changes = { 
+            { 0, 7 }, { 1, 7 }, { 2, 7 }, { 3, 9 }, { 4, 9 }, { 5, 3 }, { 6, 7 }, { 7, 3 }
+        };
+
+        const auto hashed_priority = [](const TestChange& change) 
+        { 
+            return static_cast<uint64_t>(change.src_index * 2654435761u % 101); 
+        };
+
+        const auto resolve = [&]()
+        {
+            std::vector<TestChange> applied;
+
+            resolver.resolve(std::span<const TestChange>(changes), hashed_priority, [&](const TestChange& change)
+            {
+                applied.push_back(change);
+            });
+
+            return applied;
+        };
+
+        const std::vector<TestChange> expected = resolve();
+
+        REQUIRE(expected.size() == 3);
+
+        // applied in destination order
+        REQUIRE(expected[0].dst_index == 3);
+        REQUIRE(expected[1].dst_index == 7);
+        REQUIRE(expected[2].dst_index == 9);
+
+        for (int i = 0; i < 20; i++)
+        {
+            std::shuffle(changes.begin(), changes.end(), random);
+
+            const std::vector<TestChange> applied = resolve();
+
+            for (size_t j = 0; j < expected.size(); j++)
+            {
+                REQUIRE(applied[j].src_index == expected[j].src_index);
+            }
+        }
+    }
+}
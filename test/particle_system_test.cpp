@@ -0,0 +1,236 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+
+#include "core/cell.hpp"
+#include "core/chunk_updater.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "simulation/particle_system.hpp"
+#include "utils/byte_stream.hpp"
+#include "test_worlds.hpp"
+
+namespace
+{
+    struct Landing
+    {
+        Point position;
+        Cell cell;
+    };
+
+    size_t count_cells(const ChunkManager& manager)
+    {
+        size_t count = manager.get_particles().size();
+
+        for (const Chunk* chunk : manager.get_chunks())
+        {
+            count += chunk->get_filled_cells();
+        }
+
+        return count;
+    }
+
+    void drop_block(ChunkManager& manager)
+    {
+        for (int y = -120; y < -90; y++)
+        {
+            for (int x = -20; x < 20; x++)
+            {
+                manager.set_cell(x, y, (x + y) % 4 == 0 ? Cell::Water : Cell::Sand);
+            }
+        }
+
+        for (int x = -128; x < 192; x++)
+        {
+            manager.set_cell(x, 150, Cell::Stone);
+        }
+    }
+}
+
+TEST_CASE("Particle System Test", "[ParticleSystem]")
+{
+    constexpr float c_time_step = 1.0f / 60.0f;
+
+    ParticleSystem particles;
+    std::vector<Landing> landings;
+
+    // everything below y 10 is floor
+    const auto is_free = [](int /*x*/, int y) { return y < 10; };
+    const auto land = [&](int x, int y, const Cell& cell) { landings.push_back({ { x, y }, cell }); };
+
+    SECTION("Particles speed up and land in front of the floor")
+    {
+        Cell sand = Cell::Sand;
+        sand.velocity = { 0, 5 };
+
+        particles.add(sand, 3.5f, -20.5f, 0.0f, 0.0f, 4.0f);
+
+        // 1, 2, 3, 4, 4 cells
+        for (int i = 0; i < 5; i++)
+        {
+            REQUIRE(particles.update(1.0f, c_time_step, is_free, land) == 0);
+        }
+
+        REQUIRE(particles.get_position(0) == Point(3, -7));
+
+        while (!particles.empty())
+        {
+            particles.update(1.0f, c_time_step, is_free, land);
+        }
+
+        REQUIRE(landings.size() == 1);
+        REQUIRE(landings[0].position == Point(3, 9));
+        REQUIRE(landings[0].cell.type == CellType::Sand);
+        REQUIRE(landings[0].cell.velocity == Point::zero());
+    }
+
+    SECTION("A particle on a filled cell rests on top of it")
+    {
+        particles.add(Cell::Water, 0.5f, 12.5f, 0.0f, 0.0f, 8.0f);
+
+        REQUIRE(particles.update(1.0f, c_time_step, is_free, land) == 1);
+        REQUIRE(landings[0].position == Point(0, 9));
+    }
+
+    SECTION("A buried particle with no space above it lands in the nearest free cell")
+    {
+        const auto is_free_hole = [](int x, int y) { return y < 10 || (x == 2 && y == 31); };
+
+        particles.add(Cell::Sand, 0.5f, 30.5f, 0.0f, 0.0f, 8.0f);
+
+        REQUIRE(particles.update(1.0f, c_time_step, is_free_hole, land) == 1);
+        REQUIRE(particles.empty());
+        REQUIRE(landings[0].position == Point(2, 31));
+    }
+
+    SECTION("A buried particle with no space near it waits for some")
+    {
+        bool opened = false;
+        const auto is_free_later = [&](int x, int y) { return y < 10 || (opened && x == 0 && y == 38); };
+
+        particles.add(Cell::Sand, 0.5f, 30.5f, 0.0f, 0.0f, 8.0f);
+
+        for (int i = 0; i < 3; i++)
+        {
+            REQUIRE(particles.update(1.0f, c_time_step, is_free_later, land) == 0);
+            REQUIRE(particles.size() == 1);
+            REQUIRE(particles.get_position(0) == Point(0, 30));
+        }
+
+        opened = true;
+
+        REQUIRE(particles.update(1.0f, c_time_step, is_free_later, land) == 1);
+        REQUIRE(landings[0].position == Point(0, 38));
+    }
+
+    SECTION("Life time runs out in the air")
+    {
+        Cell smoke = Cell::Smoke;
+        smoke.life_time = 0.05f;
+
+        particles.add(smoke, 0.5f, -500.5f, 0.0f, 0.0f, 1.0f);
+        particles.add(Cell::Sand, 2.5f, -500.5f, 0.0f, 0.0f, 1.0f);
+
+        for (int i = 0; i < 2; i++)
+        {
+            particles.update(0.0f, c_time_step, is_free, land);
+        }
+
+        REQUIRE(particles.size() == 2);
+        REQUIRE(particles.get_cell(0).life_time < 0.05f - c_time_step);
+
+        particles.update(0.0f, c_time_step, is_free, land);
+
+        REQUIRE(particles.size() == 1);
+        REQUIRE(particles.get_cell(0).type == CellType::Sand);
+        REQUIRE(landings.empty());
+    }
+
+    SECTION("Round trip keeps every particle")
+    {
+        particles.add(Cell::Sand, 1.5f, 2.5f, 1.0f, 3.0f, 8.0f);
+        particles.add(Cell(CellType::Water, Colour::Red), -4.5f, 0.5f, 0.0f, -2.0f, 4.0f);
+
+        std::vector<uint8_t> bytes;
+        ByteWriter writer(bytes);
+        particles.serialize(writer);
+
+        ParticleSystem loaded;
+        ByteReader reader(bytes);
+
+        REQUIRE(loaded.deserialize(reader));
+        REQUIRE(loaded.size() == 2);
+        REQUIRE(loaded.get_position(1) == Point(-5, 0));
+        REQUIRE(loaded.get_cell(1).colour == Colour::Red);
+
+        // cut short
+        ByteReader short_reader({ bytes.data(), bytes.size() - 3 });
+
+        REQUIRE_FALSE(loaded.deserialize(short_reader));
+        REQUIRE(loaded.empty());
+    }
+
+    SECTION("Falling cells fly and land without losing any")
+    {
+        ChunkManager serial;
+        ChunkManager parallel(4);
+
+        drop_block(serial);
+        drop_block(parallel);
+
+        const size_t total = count_cells(serial);
+        size_t most_airborne = 0;
+
+        for (int i = 0; i < 200; i++)
+        {
+            serial.update<ChunkUpdater>(1.0f / 59.0f);
+            parallel.update<ChunkUpdater>(1.0f / 59.0f);
+
+            REQUIRE(count_cells(serial) == total);
+            REQUIRE(count_cells(parallel) == total);
+
+            most_airborne = std::max(most_airborne, serial.get_particles().size());
+        }
+
+        REQUIRE(most_airborne > 100);
+
+        // any thread count lands the same world
+        REQUIRE(serial.get_particles().size() == parallel.get_particles().size());
+
+        for (int y = -128; y < 150; y++)
+        {
+            for (int x = -128; x < 192; x++)
+            {
+                REQUIRE(serial.get_cell(x, y)->type == parallel.get_cell(x, y)->type);
+            }
+        }
+    }
+
+    SECTION("Launching into a filled column keeps every cell")
+    {
+        ChunkManager manager;
+        manager.set_cell(0, 0, Cell::Sand);
+        manager.launch_cell(0, 0, 0.0f, 0.0f);
+        manager.update<IdleWorker>(1.0f / 59.0f);
+
+        REQUIRE(manager.get_particles().size() == 1);
+
+        // the column covers the particle and more than it can rise through
+        const Point position = manager.get_particles().get_position(0);
+
+        for (int y = position.y - 12; y <= position.y; y++)
+        {
+            manager.set_cell(position.x, y, Cell::Stone);
+        }
+
+        const size_t total = count_cells(manager);
+
+        for (int i = 0; i < 10; i++)
+        {
+            manager.update<IdleWorker>(1.0f / 59.0f);
+
+            REQUIRE(count_cells(manager) == total);
+        }
+
+        REQUIRE(manager.get_particles().empty());
+    }
+}
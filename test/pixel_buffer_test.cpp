@@ -0,0 +1,53 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "rendering/pixel_buffer.hpp"
+#include "utils/colour.hpp"
+
+TEST_CASE("Pixel Buffer Class Test", "[PixelBuffer]")
+{
+    PixelBuffer buffer(64, 64);
+
+    SECTION("Starts blank and clean")
+    {
+        REQUIRE(buffer.get_pixel(10, 10) == Colour::Blank);
+        REQUIRE_FALSE(buffer.is_dirty());
+        REQUIRE(buffer.pack_dirty_pixels().empty());
+    }
+
+    SECTION("Dirty rect covers set pixels")
+    {
+        buffer.set_pixel(2, 5, Colour::Red);
+        buffer.set_pixel(6, 3, Colour::Blue);
+
+        const IntRect& rect = buffer.get_dirty_rect();
+
+        REQUIRE(buffer.is_dirty());
+        REQUIRE(rect.min_x == 2);
+        REQUIRE(rect.min_y == 3);
+        REQUIRE(rect.max_x == 6);
+        REQUIRE(rect.max_y == 5);
+    }
+
+    SECTION("Packed pixels are row major within the dirty rect")
+    {
+        buffer.set_pixel(2, 5, Colour::Red);
+        buffer.set_pixel(6, 3, Colour::Blue);
+
+        auto pixels = buffer.pack_dirty_pixels();
+
+        // 5 wide, 3 tall
+        REQUIRE(pixels.size() == 15);
+        REQUIRE(pixels[0 + 2 * 5] == Colour::Red);
+        REQUIRE(pixels[4 + 0 * 5] == Colour::Blue);
+        REQUIRE(pixels[1 + 1 * 5] == Colour::Blank);
+    }
+
+    SECTION("Clearing keeps the pixels")
+    {
+        buffer.set_pixel(1, 1, Colour::Green);
+        buffer.clear_dirty();
+
+        REQUIRE_FALSE(buffer.is_dirty());
+        REQUIRE(buffer.get_pixel(1, 1) == Colour::Green);
+    }
+}
@@ -0,0 +1,350 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "core/cell.hpp"
+#include "simulation/chunk.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "simulation/region_store.hpp"
+#include "simulation/snapshot_saver.hpp"
+#include "simulation/world_snapshot.hpp"
+#include "utils/byte_stream.hpp"
+#include "test_worlds.hpp"
+
+namespace
+{
+    std::filesystem::path make_test_directory()
+    {
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "sand_region_store_test";
+
+        std::filesystem::remove_all(directory);
+
+        return directory;
+    }
+}
+
+TEST_CASE("Chunk serialization", "[RegionStore]")
+{
+    Chunk chunk({ 0, 0 });
+
+    chunk.set_cell({ 1, 2 }, Cell(CellType::Sand, Colour::Red));
+    chunk.set_cell({ 63, 63 }, Cell::Smoke);
+    chunk.set_cell({ 10, 40 }, Cell::Stone);
+    chunk.set_life_time(63 + 63 * ChunkContext::width, 1.5f);
+
+    std::vector<uint8_t> bytes;
+    ByteWriter writer(bytes);
+    chunk.serialize(writer);
+
+    // three cells should compress down to a handful of runs
+    REQUIRE(bytes.size() < 256);
+
+    SECTION("Round trip keeps cells and attributes")
+    {
+        Chunk loaded({ 0, 0 });
+        ByteReader reader(bytes);
+
+        REQUIRE(loaded.deserialize(reader));
+        REQUIRE(reader.get_remaining() == 0);
+
+        REQUIRE(loaded.get_filled_cells() == 3);
+        REQUIRE(loaded.get_cell({ 1, 2 }).colour == Colour::Red);
+        REQUIRE(loaded.get_type({ 10, 40 }) == CellType::Stone);
+        REQUIRE(loaded.get_cell({ 10, 40 }).colour == Colour::DarkGrey);
+        REQUIRE(loaded.get_life_time(63 + 63 * ChunkContext::width) == 1.5f);
+        REQUIRE(loaded.get_row_mask(2) == (uint64_t(1) << 1));
+        REQUIRE_FALSE(loaded.is_column_empty(63));
+    }
+
+    SECTION("Truncated data is rejected")
+    {
+        Chunk loaded({ 0, 0 });
+        ByteReader reader({ bytes.data(), bytes.size() - 1 });
+
+        REQUIRE_FALSE(loaded.deserialize(reader));
+    }
+}
+
+TEST_CASE("Region Store Class Test", "[RegionStore]")
+{
+    const std::filesystem::path directory = make_test_directory();
+
+    SECTION("Chunks round trip through region files")
+    {
+        Chunk chunk({ 0, 0 });
+        chunk.set_cell({ 5, 5 }, Cell::Water);
+
+        {
+            RegionStore store(directory);
+
+            REQUIRE_FALSE(store.has_chunk({ -3, 17 }));
+            REQUIRE(store.save_chunk({ -3, 17 }, chunk));
+            REQUIRE(store.has_chunk({ -3, 17 }));
+            REQUIRE_FALSE(store.has_chunk({ -2, 17 }));
+
+            // a bigger chunk no longer fits in place
+            chunk.set_cell({ 6, 6 }, Cell(CellType::Sand, Colour::Red));
+            REQUIRE(store.save_chunk({ -3, 17 }, chunk));
+        }
+
+        // a fresh store reads the index back from disk
+        RegionStore store(directory);
+        Chunk loaded({ 0, 0 });
+
+        REQUIRE(store.load_chunk({ -3, 17 }, loaded));
+        REQUIRE(loaded.get_type({ 5, 5 }) == CellType::Water);
+        REQUIRE(loaded.get_cell({ 6, 6 }).colour == Colour::Red);
+
+        store.erase_chunk({ -3, 17 });
+
+        REQUIRE_FALSE(store.has_chunk({ -3, 17 }));
+        REQUIRE_FALSE(store.load_chunk({ -3, 17 }, loaded));
+
+        // saving again goes back into the erased space
+        const std::filesystem::path path = directory / "r.-1.1.region";
+        const uintmax_t file_size = std::filesystem::file_size(path);
+
+        REQUIRE(store.save_chunk({ -3, 17 }, chunk));
+        REQUIRE(store.load_chunk({ -3, 17 }, loaded));
+        REQUIRE(std::filesystem::file_size(path) == file_size);
+    }
+
+    SECTION("Index entries outside the file read as missing")
+    {
+        Chunk chunk({ 0, 0 });
+        chunk.set_cell({ 5, 5 }, Cell::Water);
+
+        {
+            RegionStore store(directory);
+
+            REQUIRE(store.save_chunk({ 1, 0 }, chunk));
+            REQUIRE(store.save_chunk({ 2, 0 }, chunk));
+        }
+
+        // point the first chunk past the end of the file, the index follows a 16 byte header
+        const std::filesystem::path path = directory / "r.0.0.region";
+        const uint64_t offset = std::filesystem::file_size(path) + 4096;
+
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(16 + 1 * 16);
+            file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+        }
+
+        RegionStore store(directory);
+        Chunk loaded({ 0, 0 });
+
+        REQUIRE_FALSE(store.has_chunk({ 1, 0 }));
+        REQUIRE_FALSE(store.load_chunk({ 1, 0 }, loaded));
+        REQUIRE(store.load_chunk({ 2, 0 }, loaded));
+
+        // and can be saved again
+        REQUIRE(store.save_chunk({ 1, 0 }, chunk));
+        REQUIRE(store.load_chunk({ 1, 0 }, loaded));
+        REQUIRE(loaded.get_type({ 5, 5 }) == CellType::Water);
+    }
+
+    SECTION("Region files from elsewhere are never overwritten")
+    {
+        Chunk chunk({ 0, 0 });
+        chunk.set_cell({ 5, 5 }, Cell::Water);
+
+        {
+            RegionStore store(directory);
+
+            REQUIRE(store.save_chunk({ 0, 0 }, chunk));
+        }
+
+        // a foreign file, and a region written by a newer version, the version follows the magic
+        const std::filesystem::path foreign_path = directory / "r.1.0.region";
+        const std::filesystem::path newer_path = directory / "r.0.0.region";
+        const uint32_t newer_version = RegionStore::c_version + 1;
+
+        {
+            std::ofstream file(foreign_path, std::ios::binary);
+            file << "not a region file";
+        }
+
+        {
+            std::fstream file(newer_path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(4);
+            file.write(reinterpret_cast<const char*>(&newer_version), sizeof(newer_version));
+        }
+
+        const auto read_file = [](const std::filesystem::path& path)
+        {
+            std::ifstream file(path, std::ios::binary);
+
+            return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        };
+
+        const std::vector<char> foreign_bytes = read_file(foreign_path);
+        const std::vector<char> newer_bytes = read_file(newer_path);
+
+        {
+            RegionStore store(directory);
+            Chunk loaded({ 0, 0 });
+
+            REQUIRE_FALSE(store.has_chunk({ 0, 0 }));
+            REQUIRE_FALSE(store.load_chunk({ 0, 0 }, loaded));
+
+            REQUIRE_FALSE(store.save_chunk({ 0, 0 }, chunk));
+            REQUIRE_FALSE(store.save_chunk({ 1, 0 }, chunk));
+            REQUIRE_FALSE(store.save_chunk({ RegionStore::c_region_size, 0 }, chunk));
+
+            store.erase_chunk({ 0, 0 });
+        }
+
+        REQUIRE(read_file(foreign_path) == foreign_bytes);
+        REQUIRE(read_file(newer_path) == newer_bytes);
+    }
+
+    SECTION("Asleep chunks are paged out and back in")
+    {
+        ChunkManager manager;
+        manager.set_removal_grace_steps(0);
+        manager.enable_paging(directory, 1);
+
+        manager.set_cell(32, 32, Cell::Sand);
+        manager.set_cell(160, 32, Cell(CellType::Water, Colour::Blue));
+
+        for (int i = 0; i < 5; i++)
+            manager.update<IdleWorker>(1.0f / 59.0f);
+
+        REQUIRE(manager.get_total_chunks() == 1);
+        REQUIRE(manager.get_paging_stats().paged_out == 1);
+
+        manager.page_in({ -2, -2 }, { 2, 2 });
+
+        REQUIRE(manager.get_total_chunks() == 2);
+        REQUIRE(manager.get_paging_stats().paged_in == 1);
+        REQUIRE(manager.get_cell(32, 32)->type == CellType::Sand);
+        REQUIRE(manager.get_cell(160, 32)->colour == Colour::Blue);
+    }
+
+    SECTION("Snapshots keep the chunks on disk")
+    {
+        ChunkManager manager;
+        manager.set_removal_grace_steps(0);
+        manager.enable_paging(directory, 1);
+
+        manager.set_cell(32, 32, Cell::Sand);
+        manager.set_cell(160, 32, Cell(CellType::Water, Colour::Blue));
+
+        for (int i = 0; i < 5; i++)
+            manager.update<IdleWorker>(1.0f / 59.0f);
+
+        REQUIRE(manager.get_total_chunks() == 1);
+
+        std::vector<uint8_t> bytes;
+        ByteWriter writer(bytes);
+        manager.save_snapshot(writer);
+
+        // nothing was paged in to write it
+        REQUIRE(manager.get_total_chunks() == 1);
+        REQUIRE(manager.get_paging_stats().paged_in == 0);
+
+        ChunkManager loaded;
+        ByteReader reader(bytes);
+
+        REQUIRE(loaded.load_snapshot(reader));
+        REQUIRE(loaded.get_total_chunks() == 2);
+        REQUIRE(loaded.get_cell(32, 32)->type == CellType::Sand);
+        REQUIRE(loaded.get_cell(160, 32)->colour == Colour::Blue);
+
+        // a snapshot of only the resident chunks isnt saved
+        WorldSnapshot snapshot;
+        snapshot.capture(manager);
+        SnapshotSaver saver;
+
+        REQUIRE_FALSE(snapshot.has_whole_world());
+        REQUIRE_FALSE(saver.save(snapshot, directory / "world.snapshot"));
+
+        // from the manager it is, with the chunks on disk
+        REQUIRE(saver.save(manager, directory / "world.snapshot"));
+        REQUIRE(saver.wait());
+
+        ChunkManager from_file;
+        REQUIRE(SnapshotSaver::load(from_file, directory / "world.snapshot"));
+        REQUIRE(from_file.get_total_chunks() == 2);
+
+        // loading replaces the stored chunks too
+        ChunkManager empty;
+        std::vector<uint8_t> empty_bytes;
+        ByteWriter empty_writer(empty_bytes);
+        empty.save_snapshot(empty_writer);
+
+        ByteReader empty_reader(empty_bytes);
+        REQUIRE(manager.load_snapshot(empty_reader));
+
+        manager.page_in({ -2, -2 }, { 2, 2 });
+
+        REQUIRE(manager.get_total_chunks() == 0);
+    }
+
+    SECTION("Snapshot chunks are loaded without paging in")
+    {
+        ChunkManager saved;
+        saved.set_cell(160, 32, Cell::Stone);
+
+        std::vector<uint8_t> bytes;
+        ByteWriter writer(bytes);
+        saved.save_snapshot(writer);
+
+        ChunkManager manager;
+        manager.set_removal_grace_steps(0);
+        manager.enable_paging(directory, 1);
+
+        manager.set_cell(32, 32, Cell::Sand);
+        manager.set_cell(160, 32, Cell::Water);
+
+        for (int i = 0; i < 5; i++)
+            manager.update<IdleWorker>(1.0f / 59.0f);
+
+        REQUIRE(manager.get_paging_stats().paged_out == 1);
+
+        ByteReader reader(bytes);
+        REQUIRE(manager.load_snapshot(reader));
+
+        REQUIRE(manager.get_paging_stats().paged_in == 0);
+        REQUIRE(manager.get_cell(160, 32)->type == CellType::Stone);
+    }
+
+    SECTION("Broken snapshots keep the chunks on disk")
+    {
+        ChunkManager saved;
+        saved.set_cell(160, 32, Cell::Stone);
+
+        std::vector<uint8_t> bytes;
+        ByteWriter writer(bytes);
+        saved.save_snapshot(writer);
+        bytes.resize(bytes.size() - 2);
+
+        ChunkManager manager;
+        manager.set_removal_grace_steps(0);
+        manager.enable_paging(directory, 1);
+
+        manager.set_cell(32, 32, Cell::Sand);
+        manager.set_cell(160, 32, Cell::Water);
+
+        for (int i = 0; i < 5; i++)
+            manager.update<IdleWorker>(1.0f / 59.0f);
+
+        REQUIRE(manager.get_paging_stats().paged_out == 1);
+
+        ByteReader reader(bytes);
+        REQUIRE_FALSE(manager.load_snapshot(reader));
+
+        manager.page_in({ -2, -2 }, { 2, 2 });
+
+        REQUIRE(manager.get_total_chunks() == 2);
+        REQUIRE(manager.get_cell(32, 32)->type == CellType::Sand);
+        REQUIRE(manager.get_cell(160, 32)->type == CellType::Water);
+    }
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,109 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/cell.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "simulation/chunk_worker.hpp"
+#include "simulation/simulation_metrics.hpp"
+#include "test_worlds.hpp"
+
+namespace
+{
+    // every cell tries to move into the same spot
+    class CrowdWorker : public ChunkWorker
+    {
+    public:
+        CrowdWorker(ChunkManager& manager, Chunk* chunk) : ChunkWorker(manager, chunk) { }
+
+    protected:
+        void update_cell(const Cell& /*cell*/, int x, int y) override
+        {
+            if (is_empty(10, 10)) move_cell(x, y, 10, 10);
+        }
+    };
+}
+
+TEST_CASE("Simulation Metrics Test", "[SimulationMetrics]")
+{
+    ChunkManager manager;
+
+    manager.set_cell(9, 9, Cell::Sand);
+    manager.set_cell(11, 11, Cell::Sand);
+    manager.set_cell(9, 11, Cell::Sand);
+
+    SECTION("Nothing is collected while disabled")
+    {
+        manager.update<CrowdWorker>(1.0f / 59.0f);
+
+        REQUIRE(manager.get_metrics().get_summary().steps == 0);
+        REQUIRE(manager.get_metrics().get_last_step().cells_visited == 0);
+    }
+
+    SECTION("Counters for a step")
+    {
+        manager.update<CrowdWorker>(1.0f / 59.0f); // woken up
+        manager.get_metrics().set_enabled(true);
+        manager.update<CrowdWorker>(1.0f / 59.0f);
+
+        const StepMetrics& step = manager.get_metrics().get_last_step();
+
+        REQUIRE(step.cells_visited == 3);
+        REQUIRE(step.moves_queued == 3);
+        REQUIRE(step.moves_dropped == 2);
+        REQUIRE(step.chunks_awake == 1);
+        REQUIRE(step.chunks_asleep == 0);
+        REQUIRE(step.tiles_awake == 1);
+        REQUIRE(step.get_phase_ms(MetricPhase::Update) >= 0.0);
+    }
+
+    SECTION("Only cells in awake tiles are visited")
+    {
+        ChunkManager tiled;
+
+        // a settled wall across the middle of the chunk and a spot in each corner
+        for (int x = 0; x < 64; x++)
+        {
+            tiled.set_cell(x, 32, Cell::Stone);
+        }
+
+        tiled.update<IdleWorker>(1.0f / 59.0f);
+        tiled.update<IdleWorker>(1.0f / 59.0f);
+
+        tiled.set_cell(2, 2, Cell::Stone);
+        tiled.set_cell(61, 61, Cell::Stone);
+        tiled.update<IdleWorker>(1.0f / 59.0f); // woken up
+        tiled.get_metrics().set_enabled(true);
+        tiled.update<IdleWorker>(1.0f / 59.0f);
+
+        // one rect around both spots would have covered the whole wall
+        REQUIRE(tiled.get_metrics().get_last_step().cells_visited == 2);
+    }
+
+    SECTION("Summary over the window")
+    {
+        SimulationMetrics metrics;
+        metrics.set_enabled(true);
+
+        for (int i = 1; i <= 4; i++)
+        {
+            metrics.add_cells_visited(i * 10);
+            metrics.add_phase_time(MetricPhase::ApplyMoves, i * 0.001);
+            metrics.end_step();
+        }
+
+        const MetricsSummary summary = metrics.get_summary();
+
+        REQUIRE(summary.steps == 4);
+        REQUIRE(summary.total.cells_visited == 100);
+        REQUIRE(summary.average.cells_visited == 25);
+        REQUIRE(summary.peak.cells_visited == 40);
+        REQUIRE(summary.peak.get_phase_ms(MetricPhase::ApplyMoves) > 3.99);
+
+        // old steps fall out of the window
+        for (int i = 0; i < SimulationMetrics::c_window_size; i++)
+        {
+            metrics.end_step();
+        }
+
+        REQUIRE(metrics.get_summary().peak.cells_visited == 0);
+    }
+}
@@ -0,0 +1,157 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <vector>
+
+#include "core/cell.hpp"
+#include "core/chunk_updater.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "simulation/snapshot_saver.hpp"
+#include "utils/byte_stream.hpp"
+#include "test_worlds.hpp"
+
+namespace
+{
+    void fill_world(ChunkManager& manager)
+    {
+        manager.set_cell(-100, -100, Cell::Stone);
+        manager.set_cell(5, 5, Cell(CellType::Sand, Colour::Red));
+        manager.set_cell(150, 40, Cell::Smoke);
+
+        manager.update<IdleWorker>(1.0f / 45.0f); // leaves time in the accumulator
+    }
+}
+
+TEST_CASE("Snapshot Test", "[Snapshot]")
+{
+    ChunkManager manager;
+    fill_world(manager);
+
+    SECTION("Round trip restores the world")
+    {
+        std::vector<uint8_t> bytes;
+        ByteWriter writer(bytes);
+        manager.save_snapshot(writer);
+
+        ChunkManager loaded;
+        loaded.set_cell(60, 60, Cell::Water); // replaced by the snapshot
+
+        ByteReader reader(bytes);
+        REQUIRE(loaded.load_snapshot(reader));
+
+        REQUIRE(loaded.get_total_chunks() == 3);
+        REQUIRE(loaded.get_accumulator() == manager.get_accumulator());
+        REQUIRE(loaded.get_cell(-100, -100)->type == CellType::Stone);
+        REQUIRE(loaded.get_cell(5, 5)->colour == Colour::Red);
+        REQUIRE(loaded.get_cell(150, 40)->life_time == manager.get_cell(150, 40)->life_time);
+        REQUIRE(loaded.is_empty(60, 60));
+
+        for (const Chunk* chunk : loaded.get_chunks())
+        {
+            REQUIRE(chunk->get_current_rect().min_x <= chunk->get_current_rect().max_x);
+        }
+    }
+
+    SECTION("Particles in flight are saved")
+    {
+        ChunkManager falling;
+        falling.set_cell(0, -120, Cell(CellType::Sand, Colour::Red));
+
+        while (falling.get_particles().empty())
+        {
+            falling.update<ChunkUpdater>(1.0f / 59.0f);
+        }
+
+        std::vector<uint8_t> bytes;
+        ByteWriter writer(bytes);
+        falling.save_snapshot(writer);
+
+        ChunkManager loaded;
+        ByteReader reader(bytes);
+        REQUIRE(loaded.load_snapshot(reader));
+
+        REQUIRE(loaded.get_particles().size() == 1);
+        REQUIRE(loaded.get_particles().get_position(0) == falling.get_particles().get_position(0));
+        REQUIRE(loaded.get_particles().get_cell(0).colour == Colour::Red);
+    }
+
+    SECTION("A loaded world carries on the same")
+    {
+        ChunkManager running;
+        fill_mixed(running, 3);
+
+        for (int i = 0; i < 60; i++)
+        {
+            running.update<ChunkUpdater>(1.0f / 59.0f);
+        }
+
+        std::vector<uint8_t> bytes;
+        ByteWriter writer(bytes);
+        running.save_snapshot(writer);
+
+        ChunkManager loaded;
+        ByteReader reader(bytes);
+        REQUIRE(loaded.load_snapshot(reader));
+        REQUIRE(same_world(running, loaded));
+
+        // past the point the smoke runs out
+        for (int i = 0; i < 180; i++)
+        {
+            running.update<ChunkUpdater>(1.0f / 59.0f);
+            loaded.update<ChunkUpdater>(1.0f / 59.0f);
+        }
+
+        REQUIRE(running.get_step() == loaded.get_step());
+        REQUIRE(same_world(running, loaded));
+    }
+
+    SECTION("Broken snapshots leave the world as it was")
+    {
+        std::vector<uint8_t> bytes;
+        ByteWriter writer(bytes);
+        manager.save_snapshot(writer);
+
+        manager.set_cell(-60, 60, Cell::Water); // not in the snapshot
+
+        // a bad body, the chunks read fine but the particles are cut off
+        std::vector<uint8_t> truncated = bytes;
+        truncated.resize(truncated.size() - 2);
+
+        ByteReader reader(truncated);
+        REQUIRE_FALSE(manager.load_snapshot(reader));
+        REQUIRE(manager.get_total_chunks() == 4);
+        REQUIRE(manager.get_cell(-60, 60)->type == CellType::Water);
+        REQUIRE(manager.get_cell(5, 5)->colour == Colour::Red);
+
+        // a bad header does the same
+        bytes[0] ^= 0xFF;
+
+        ByteReader header_reader(bytes);
+        REQUIRE_FALSE(manager.load_snapshot(header_reader));
+        REQUIRE(manager.get_total_chunks() == 4);
+        REQUIRE(manager.get_cell(-60, 60)->type == CellType::Water);
+
+        // the chunks read for the broken snapshot are pooled again
+        REQUIRE(manager.get_pool_stats().pooled >= 3);
+    }
+
+    SECTION("Background save from a copy")
+    {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "sand_snapshot_test.snapshot";
+        SnapshotSaver saver;
+
+        REQUIRE(saver.save(manager, path));
+
+        // the saved copy isnt affected by later changes
+        manager.set_cell(5, 5, Cell());
+
+        REQUIRE(saver.wait());
+        REQUIRE_FALSE(saver.is_saving());
+
+        ChunkManager loaded;
+        REQUIRE(SnapshotSaver::load(loaded, path));
+        REQUIRE(loaded.get_cell(5, 5)->type == CellType::Sand);
+
+        std::filesystem::remove(path);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+
+#include "core/cell.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "simulation/chunk_worker.hpp"
+#include "utils/counter_random.hpp"
+
+// workers and worlds shared by the simulation tests
+
+// leaves every cell where it is
+class IdleWorker : public ChunkWorker
+{
+public:
+    IdleWorker(ChunkManager& manager, Chunk* chunk) : ChunkWorker(manager, chunk) { }
+
+protected:
+    void update_cell(const Cell& /*cell*/, int /*x*/, int /*y*/) override { }
+};
+
+// falls down, otherwise slides to a random side
+class FallWorker : public ChunkWorker
+{
+public:
+    FallWorker(ChunkManager& manager, Chunk* chunk) : ChunkWorker(manager, chunk) { }
+
+protected:
+    void update_cell(const Cell& cell, int x, int y) override
+    {
+        if (cell.type == CellType::Stone) return;
+
+        const int side = (get_random(x, y) & 1) ? 1 : -1;
+        const int spread = cell.type == CellType::Water ? 0 : 1;
+
+        if (is_empty(x, y + 1))                     move_cell(x, y, x, y + 1);
+        else if (is_empty(x + side, y + spread))    move_cell(x, y, x + side, y + spread);
+        else if (is_empty(x - side, y + spread))    move_cell(x, y, x - side, y + spread);
+    }
+};
+
+// a block of sand and water over a flat stone floor, 120 * 60 + 320 cells
+inline void fill_pour(ChunkManager& manager)
+{
+    for (int y = -100; y < -40; y++)
+    {
+        for (int x = -60; x < 60; x++)
+        {
+            manager.set_cell(x, y, (x + y) % 3 == 0 ? Cell::Water : Cell::Sand);
+        }
+    }
+
+    for (int x = -128; x < 192; x++)
+    {
+        manager.set_cell(x, 150, Cell::Stone);
+    }
+}
+
+// a dense pour of sand with water and smoke mixed in over a bumpy floor
+inline void fill_mixed(ChunkManager& manager, uint64_t seed)
+{
+    const CounterRandom random(seed);
+
+    for (int y = -100; y < 40; y++)
+    {
+        for (int x = -90; x < 90; x++)
+        {
+            const uint32_t value = random.get({ x, y }, 0) % 16;
+
+            if (value < 10)       manager.set_cell(x, y, Cell::Sand);
+            else if (value < 13)  manager.set_cell(x, y, Cell::Water);
+            else if (value < 14)  manager.set_cell(x, y, Cell::Smoke);
+        }
+    }
+
+    for (int x = -128; x < 192; x++)
+    {
+        manager.set_cell(x, 120 - (x & 7), Cell::Stone);
+    }
+}
+
+// every cell and particle of the area the worlds above use
+inline bool same_world(ChunkManager& a, ChunkManager& b)
+{
+    for (int y = -128; y < 192; y++)
+    {
+        for (int x = -128; x < 192; x++)
+        {
+            const Cell cell_a = *a.get_cell(x, y);
+            const Cell cell_b = *b.get_cell(x, y);
+
+            if (cell_a.type != cell_b.type || cell_a.colour != cell_b.colour) return false;
+            if (cell_a.velocity != cell_b.velocity || cell_a.life_time != cell_b.life_time) return false;
+        }
+    }
+
+    return a.get_particles().size() == b.get_particles().size();
+}
@@ -0,0 +1,40 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <vector>
+
+#include "utils/thread_pool.hpp"
+
+TEST_CASE("Thread Pool Class Test", "[ThreadPool]")
+{
+    ThreadPool pool(4);
+
+    SECTION("Thread count includes caller")
+    {
+        REQUIRE(pool.get_thread_count() == 4);
+    }
+
+    SECTION("Every task runs once")
+    {
+        std::vector<std::atomic<int>> runs(1000);
+
+        pool.parallel_for(runs.size(), [&](size_t i) { runs[i]++; });
+
+        for (auto& run : runs)
+        {
+            REQUIRE(run == 1);
+        }
+    }
+
+    SECTION("Tasks finish before returning")
+    {
+        std::atomic<int> total = 0;
+
+        for (int phase = 0; phase < 100; phase++)
+        {
+            pool.parallel_for(16, [&](size_t) { total++; });
+
+            REQUIRE(total == (phase + 1) * 16);
+        }
+    }
+}
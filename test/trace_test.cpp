@@ -0,0 +1,46 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "utils/trace.hpp"
+
+// tracing is compiled out unless the build has SAND_TRACING
+#ifdef SAND_TRACING
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+TEST_CASE("Tracer Test", "[Tracer]")
+{
+    Tracer::get().clear();
+
+    {
+        TRACE_SCOPE("outer");
+
+        std::thread worker([]()
+        {
+            TRACE_SCOPE_CHUNK("inner", Point(3, -2));
+        });
+
+        worker.join();
+    }
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "sand_trace_test.json";
+
+    REQUIRE(TRACE_WRITE(path));
+
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+
+    const std::string trace = contents.str();
+
+    REQUIRE(trace.find("\"name\":\"outer\",\"ph\":\"X\"") != std::string::npos);
+    REQUIRE(trace.find("\"chunk_x\":3,\"chunk_y\":-2") != std::string::npos);
+    REQUIRE(trace.find("\"thread_name\"") != std::string::npos);
+
+    std::filesystem::remove(path);
+}
+
+#endif
@@ -0,0 +1,174 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "core/cell.hpp"
+#include "core/chunk_updater.hpp"
+#include "simulation/chunk_manager.hpp"
+#include "simulation/simulation_thread.hpp"
+#include "simulation/world_snapshot.hpp"
+
+namespace
+{
+    const Chunk* find_chunk(const WorldSnapshot& snapshot, Point position)
+    {
+        for (const Chunk* chunk : snapshot.get_chunks())
+        {
+            if (chunk->get_position() == position) return chunk;
+        }
+
+        return nullptr;
+    }
+
+    // every cell of the manager's chunks is the same in the snapshot
+    bool matches(ChunkManager& manager, const WorldSnapshot& snapshot)
+    {
+        if (manager.get_chunks().size() != snapshot.get_chunks().size()) return false;
+
+        for (const Chunk* chunk : manager.get_chunks())
+        {
+            const Chunk* copy = find_chunk(snapshot, chunk->get_position());
+
+            if (copy == nullptr) return false;
+
+            for (int i = 0; i < ChunkContext::width * ChunkContext::height; i++)
+            {
+                if (chunk->get_type(i) != copy->get_type(i) || chunk->get_colour(i) != copy->get_colour(i)) return false;
+            }
+        }
+
+        return manager.get_particles().size() == snapshot.get_particles().size();
+    }
+}
+
+TEST_CASE("World Snapshot Test", "[WorldSnapshot]")
+{
+    ChunkManager manager;
+    WorldSnapshot snapshot;
+
+    manager.set_cell(-100, -100, Cell::Stone);
+    manager.set_cell(5, 5, Cell::Sand);
+
+    SECTION("Only changed chunks are copied")
+    {
+        snapshot.capture(manager);
+
+        REQUIRE(snapshot.get_copied_chunks() == 2);
+        REQUIRE(matches(manager, snapshot));
+
+        // let both chunks settle
+        for (int i = 0; i < 100; i++)
+        {
+            manager.update<ChunkUpdater>(1.0f / 59.0f);
+        }
+
+        snapshot.capture(manager);
+        snapshot.capture(manager);
+
+        REQUIRE(snapshot.get_copied_chunks() == 0);
+
+        manager.set_cell(-100, -101, Cell::Stone);
+        snapshot.capture(manager);
+
+        REQUIRE(snapshot.get_copied_chunks() == 1);
+        REQUIRE(matches(manager, snapshot));
+    }
+
+    SECTION("Copies keep changes nobody read yet")
+    {
+        snapshot.capture(manager);
+
+        for (Chunk* chunk : snapshot.get_chunks())
+        {
+            chunk->clear_changed_rect();
+        }
+
+        manager.set_cell(1, 1, Cell::Stone);
+        snapshot.capture(manager);
+        manager.set_cell(9, 9, Cell::Stone);
+        snapshot.capture(manager);
+
+        const IntRect& changed_rect = find_chunk(snapshot, { 0, 0 })->get_changed_rect();
+
+        REQUIRE(changed_rect.min_x == 1);
+        REQUIRE(changed_rect.max_x == 9);
+
+        // the manager's chunks handed their changes over
+        for (const Chunk* chunk : manager.get_chunks())
+        {
+            REQUIRE(chunk->get_changed_rect().min_x > chunk->get_changed_rect().max_x);
+        }
+    }
+
+    SECTION("Removed chunks leave the snapshot")
+    {
+        manager.set_removal_grace_steps(0);
+        snapshot.capture(manager);
+
+        manager.set_cell(5, 5, Cell());
+
+        for (int i = 0; i < 3; i++)
+        {
+            manager.update<ChunkUpdater>(1.0f / 59.0f);
+        }
+
+        snapshot.capture(manager);
+
+        REQUIRE(manager.get_total_chunks() == 1);
+        REQUIRE(snapshot.get_chunks().size() == 1);
+        REQUIRE(find_chunk(snapshot, { 0, 0 }) == nullptr);
+    }
+
+    SECTION("Time spent drawing the snapshot goes into the next step")
+    {
+        manager.get_metrics().set_enabled(true);
+        snapshot.capture(manager);
+
+        snapshot.add_pre_draw_time(0.004);
+        snapshot.capture(manager);
+        manager.update<ChunkUpdater>(1.0f / 59.0f);
+        snapshot.capture(manager);
+
+        REQUIRE(manager.get_metrics().get_last_step().get_phase_ms(MetricPhase::PreDraw) == 4.0);
+        REQUIRE(snapshot.get_metrics_summary().peak.get_phase_ms(MetricPhase::PreDraw) == 4.0);
+
+        // handed over once
+        manager.update<ChunkUpdater>(1.0f / 59.0f);
+
+        REQUIRE(manager.get_metrics().get_last_step().get_phase_ms(MetricPhase::PreDraw) == 0.0);
+    }
+
+    SECTION("Pipelined updates give the same world")
+    {
+        // the same thread count, so both create the same chunks
+        ChunkManager reference(2);
+        ChunkManager pipelined_manager(2);
+
+        for (ChunkManager* world : { &reference, &pipelined_manager })
+        {
+            world->set_cell(-100, -100, Cell::Stone);
+            world->set_cell(5, 5, Cell::Sand);
+        }
+
+        SimulationThread simulation(pipelined_manager);
+
+        for (int i = 0; i < 60; i++)
+        {
+            // edits go in before the same step in both
+            reference.set_cell(i, -20, Cell::Water);
+            simulation.set_cell(i, -20, Cell::Water);
+
+            reference.update<ChunkUpdater>(1.0f / 59.0f);
+            simulation.advance<ChunkUpdater>(1.0f / 59.0f);
+
+            // the snapshot is one update behind while the next one runs
+            REQUIRE(simulation.get_snapshot().get_step() == static_cast<uint64_t>(i));
+        }
+
+        simulation.wait();
+
+        REQUIRE(pipelined_manager.get_step() == reference.get_step());
+
+        snapshot.capture(pipelined_manager);
+
+        REQUIRE(matches(reference, snapshot));
+    }
+}